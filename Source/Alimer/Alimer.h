@@ -38,6 +38,8 @@
 #include "Core/Platform.h"
 #include "Core/Plugin.h"
 #include "Core/Log.h"
+#include "Core/Timer.h"
+#include "Core/JobSystem.h"
 
 // IO
 #include "IO/Stream.h"
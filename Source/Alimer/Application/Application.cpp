@@ -23,6 +23,11 @@
 #include "AlimerVersion.h"
 #include "../Application/Application.h"
 #include "../Scene/Systems/CameraSystem.h"
+#include "../Scene/Systems/TransformSystem.h"
+#include "../Scene/Systems/SpatialSystem.h"
+#include "../Scene/Components/BoundsComponent.h"
+#include "../Scene/Components/CameraComponent.h"
+#include "../Scene/Components/TransformComponent.h"
 #include "../IO/Path.h"
 #include "../Core/Platform.h"
 #include "../Core/Log.h"
@@ -38,6 +43,7 @@ namespace Alimer
         , _headless(false)
         , _settings{}
         , _log(new Logger())
+        , _jobs(new JobSystem())
         , _entities{}
         , _systems(_entities)
         , _scene(_entities)
@@ -50,6 +56,7 @@ namespace Alimer
     {
         _paused = true;
         _running = false;
+        _framePipeline.Stop();
 
         PluginManager::DeleteInstance();
 
@@ -76,6 +83,7 @@ namespace Alimer
 
             // Assign as window handle.
             _settings.renderingSettings.windowHandle = _window->GetHandle();
+            SubscribeToEvent(_window->resizeEvent, &Application::HandleWindowResize);
 
             // Create and init graphics.
             _graphicsDevice = GraphicsDevice::Create(_settings.preferredGraphicsBackend, _settings.validation);
@@ -99,9 +107,18 @@ namespace Alimer
         Initialize();
 
         // Setup and configure all systems.
+        _systems.Add<TransformSystem>();
+        _systems.Add<SpatialSystem>();
         _systems.Add<CameraSystem>();
+        _systems.SetFixedTimestep(_settings.fixedUpdateRate, _settings.maxFixedUpdates);
+
         _renderContext.SetDevice(_graphicsDevice.Get());
 
+        if (_settings.pipelinedRendering && !_headless)
+        {
+            _framePipeline.Start([this](const RenderFrameData& frame) { RenderFrame(frame); });
+        }
+
         ALIMER_LOGINFO("Engine initialized with success.");
         _running = true;
         //BeginRun();
@@ -128,13 +145,30 @@ namespace Alimer
             double frameTime = _timer.Frame();
             double deltaTime = _timer.GetElapsed();
 
-            // Update all systems.
-            _systems.Update(deltaTime);
+            // Recycle scratch memory of the oldest frame, which is no longer referenced by simulation or rendering.
+            _frameAllocator.NextFrame();
+
+            // Update all systems, fixed phase systems at their own rate.
+            _systems.Update(_timer.GetFrameTime());
 
-            // Render single frame.
-            if (!_window->IsMinimized())
+            // Render single frame, on the render thread while the next frame simulates when pipelined.
+            if (!_headless && !_window->IsMinimized())
             {
-                RenderFrame(frameTime, deltaTime);
+                RenderFrameData& frame = _framePipeline.GetExtractFrame();
+                frame.frameIndex = _frameIndex++;
+                frame.frameTime = frameTime;
+                frame.elapsedTime = deltaTime;
+                frame.interpolationAlpha = static_cast<float>(_systems.GetInterpolationAlpha());
+                ExtractFrame(frame);
+
+                if (_framePipeline.IsRunning())
+                {
+                    _framePipeline.Submit();
+                }
+                else
+                {
+                    RenderFrame(frame);
+                }
             }
         }
 
@@ -142,11 +176,37 @@ namespace Alimer
         _input->Update();
     }
 
-    void Application::RenderFrame(double frameTime, double elapsedTime)
+    void Application::ExtractFrame(RenderFrameData& frame)
+    {
+        frame.Clear(_frameAllocator);
+
+        _entities.Each<CameraComponent>([&frame](Entity entity, CameraComponent& camera) {
+            RenderView view;
+            view.camera = entity.GetId();
+            view.view = camera.GetView();
+            view.projection = camera.GetProjection();
+            frame.views.push_back(view);
+        });
+
+        _entities.GetQuery<TransformComponent, BoundsComponent>().Each<TransformComponent, BoundsComponent>(
+            [&frame](Entity entity, TransformComponent& transform, BoundsComponent& bounds) {
+            RenderItem item;
+            item.entity = entity.GetId();
+            item.world = transform.GetTransform().GetMatrix();
+            item.bounds = bounds.box.Transformed(item.world);
+            frame.items.push_back(item);
+        });
+
+        OnExtractFrame(frame);
+    }
+
+    void Application::RenderFrame(const RenderFrameData& frame)
     {
         if (_headless)
             return;
 
+        _renderContext.SetInterpolationAlpha(frame.interpolationAlpha);
+
         if (!_graphicsDevice->BeginFrame())
             return;
 
@@ -155,6 +215,13 @@ namespace Alimer
         RenderPassDescriptor renderPass = {};
         renderPass.colorAttachments[0].clearColor = Color4(0.0f, 0.2f, 0.4f, 1.0f);
         commandBuffer->BeginRenderPass(&renderPass);
+
+        // Render scene from the extracted views and items, never from live entity data.
+        if (_renderPipeline && !frame.views.empty())
+        {
+            _renderPipeline->Render(_renderContext, frame);
+        }
+
         commandBuffer->EndRenderPass();
 
         /*
@@ -164,14 +231,7 @@ namespace Alimer
         commandBuffer->BeginRenderPass(nullptr, Color4(0.0f, 0.2f, 0.4f, 1.0f));
 
         // Call OnRenderFrame for custom rendering frame logic.
-        OnRenderFrame(commandBuffer, frameTime, elapsedTime);
-
-        // Render scene to default command buffer.
-        if (_renderPipeline)
-        {
-            //auto camera = _scene.GetActiveCamera()->GetComponent<CameraComponent>()->camera;
-            //_renderPipeline->Render(_renderContext, { camera });
-        }
+        OnRenderFrame(commandBuffer, frame.frameTime, frame.elapsedTime);
 
         // End swap chain render pass.
         commandBuffer->EndRenderPass();
@@ -193,6 +253,14 @@ namespace Alimer
         //commandBuffer->EndRenderPass();
     }
 
+    void Application::HandleWindowResize(WindowResizeEvent& event)
+    {
+        ALIMER_UNUSED(event);
+
+        // The swapchain follows the window, let the frame in flight finish presenting first.
+        _framePipeline.WaitIdle();
+    }
+
     void Application::Exit()
     {
         _paused = true;
@@ -210,6 +278,9 @@ namespace Alimer
         {
             // TODO: Fire event.
             _paused = true;
+
+            // Minimizing pauses, nothing may be presenting while the window surface goes away.
+            _framePipeline.WaitIdle();
         }
     }
 
@@ -31,6 +31,8 @@
 #include "../Core/Object.h"
 #include "../Core/Log.h"
 #include "../Core/Timer.h"
+#include "../Base/FrameAllocator.h"
+#include "../Core/JobSystem.h"
 #include "../Core/PluginManager.h"
 #include "../Application/Window.h"
 #include "../Application/GameSystem.h"
@@ -43,6 +45,7 @@
 #include "../Scene/Scene.h"
 #include "../Renderer/RenderContext.h"
 #include "../Renderer/RenderPipeline.h"
+#include "../Renderer/FramePipeline.h"
 
 namespace Alimer
 {
@@ -57,6 +60,14 @@ namespace Alimer
 #endif
 
         RenderingSettings renderingSettings = {};
+
+        /// Fixed simulation rate in updates per second, zero updates every system once per frame.
+        double fixedUpdateRate = 0.0;
+        /// Maximum fixed updates per frame before simulation time is dropped.
+        uint32_t maxFixedUpdates = 5;
+
+        /// Render frame N on a render thread while simulating frame N + 1.
+        bool pipelinedRendering = false;
     };
 
     /// Application for main loop and all modules and OS setup.
@@ -94,6 +105,12 @@ namespace Alimer
 
         Timer &GetFrameTimer() { return _timer; }
 
+        /// Return allocator for scratch memory valid until the frame after the next one.
+        FrameAllocator& GetFrameAllocator() { return _frameAllocator; }
+
+        inline JobSystem* GetJobs() const { return _jobs.Get(); }
+
+        inline SystemManager* GetSystems() { return &_systems; }
         inline ResourceManager* GetResources() { return &_resources; }
         inline const Window* GetMainWindow() const { return _window.Get(); }
         inline const GraphicsDevice* GetGraphicsDevice() const { return _graphicsDevice.Get(); }
@@ -104,6 +121,8 @@ namespace Alimer
         void PlatformConstruct();
         bool InitializeBeforeRun();
         void LoadPlugins();
+        /// Wait for the frame in flight before the window, and with it the swapchain, changes size.
+        void HandleWindowResize(WindowResizeEvent& event);
 
     protected:
         /// Called after setup and engine initialization with all modules initialized.
@@ -112,8 +131,14 @@ namespace Alimer
         /// Cleanup after the main loop. 
         virtual void OnExiting() { }
 
-        /// Render after frame update.
-        void RenderFrame(double frameTime, double elapsedTime);
+        /// Extract render data after frame update. Runs on the main thread, entity data must not be referenced afterwards.
+        void ExtractFrame(RenderFrameData& frame);
+
+        /// Called at the extract point to copy custom render data.
+        virtual void OnExtractFrame(RenderFrameData& frame) { ALIMER_UNUSED(frame); }
+
+        /// Render extracted frame, on the render thread when pipelined.
+        void RenderFrame(const RenderFrameData& frame);
 
         /// Called during rendering single frame.
         virtual void OnRenderFrame(CommandBuffer* commandBuffer, double frameTime, double elapsedTime);
@@ -129,6 +154,8 @@ namespace Alimer
 
         UniquePtr<Logger> _log;
         Timer _timer;
+        FrameAllocator _frameAllocator;
+        UniquePtr<JobSystem> _jobs;
         ResourceManager _resources;
         UniquePtr<Window> _window;
         UniquePtr<GraphicsDevice> _graphicsDevice;
@@ -141,6 +168,8 @@ namespace Alimer
         Scene _scene;
         RenderContext _renderContext;
         RenderPipeline* _renderPipeline = nullptr;
+        FramePipeline _framePipeline;
+        uint64_t _frameIndex = 0;
 
     private:
         DISALLOW_COPY_MOVE_AND_ASSIGN(Application);
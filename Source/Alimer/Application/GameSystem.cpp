@@ -20,17 +20,266 @@
 // THE SOFTWARE.
 //
 
-#include "../Application//GameSystem.h"
+#include "../Application/GameSystem.h"
+#include "../Scene/EntityCommandBuffer.h"
+#include "../Core/Log.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
 
 namespace Alimer
 {
     uint32_t GameSystemIDMapping::ids;
 
+    bool GameSystem::ConflictsWith(const GameSystem& other) const
+    {
+        if (!_declaredAccess || !other._declaredAccess)
+            return true;
+
+        return _writeMask.Intersects(other._writeMask)
+            || _writeMask.Intersects(other._readMask)
+            || other._writeMask.Intersects(_readMask);
+    }
+
+    void SystemManager::Add(uint32_t id, const IntrusivePtr<GameSystem>& system)
+    {
+        uint32_t index;
+        auto it = _systemIndices.find(id);
+        if (it != _systemIndices.end())
+        {
+            index = it->second;
+            _systems[index] = system;
+        }
+        else
+        {
+            index = static_cast<uint32_t>(_systems.size());
+            _systemIndices[id] = index;
+            _systems.push_back(system);
+        }
+
+        _systems[index]->_id = id;
+        _systems[index]->Initialize(_entities);
+        _graphDirty = true;
+    }
+
+    void SystemManager::BuildGraph()
+    {
+        const uint32_t count = static_cast<uint32_t>(_systems.size());
+
+        // Explicit before/after constraints.
+        std::vector<std::vector<uint32_t>> successors(count);
+        std::vector<uint32_t> inDegree(count, 0);
+        auto addConstraint = [&](uint32_t from, uint32_t to) {
+            successors[from].push_back(to);
+            inDegree[to]++;
+        };
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const GameSystem& system = *_systems[i];
+            for (uint32_t id : system._runBefore)
+            {
+                auto it = _systemIndices.find(id);
+                if (it != _systemIndices.end())
+                    addConstraint(i, it->second);
+            }
+
+            for (uint32_t id : system._runAfter)
+            {
+                auto it = _systemIndices.find(id);
+                if (it != _systemIndices.end())
+                    addConstraint(it->second, i);
+            }
+        }
+
+        // Kahn's algorithm, picking the earliest registered ready system for a deterministic order.
+        std::vector<uint32_t> order;
+        std::vector<bool> placed(count, false);
+        order.reserve(count);
+        while (order.size() < count)
+        {
+            uint32_t next = count;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if (!placed[i] && inDegree[i] == 0)
+                {
+                    next = i;
+                    break;
+                }
+            }
+
+            if (next == count)
+            {
+                // Cycle in explicit constraints: fall back to registration order for the remainder.
+                ALIMER_LOGERROR("Cyclic system ordering constraints, ignoring them for the remaining systems.");
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    if (!placed[i])
+                    {
+                        placed[i] = true;
+                        order.push_back(i);
+                    }
+                }
+                break;
+            }
+
+            placed[next] = true;
+            order.push_back(next);
+            for (uint32_t successor : successors[next])
+            {
+                inDegree[successor]--;
+            }
+        }
+
+        // Every edge points forward in the order, so the graph is acyclic. Conflicting systems keep their relative order.
+        std::vector<uint32_t> position(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            position[order[i]] = i;
+        }
+
+        _graph.clear();
+        _graph.reserve(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            std::unique_ptr<SystemNode> node(new SystemNode());
+            node->system = order[i];
+            node->dependencies = 0;
+            _graph.push_back(std::move(node));
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const GameSystem& system = *_systems[order[i]];
+            for (uint32_t j = i + 1; j < count; ++j)
+            {
+                const uint32_t other = order[j];
+                bool constrained = std::find(successors[order[i]].begin(), successors[order[i]].end(), other) != successors[order[i]].end();
+                if (constrained || system.ConflictsWith(*_systems[other]))
+                {
+                    _graph[i]->successors.push_back(j);
+                    _graph[j]->dependencies++;
+                }
+            }
+        }
+
+        _graphDirty = false;
+    }
+
+    void SystemManager::RunSystem(uint32_t node, uint32_t phases, JobSystem* jobs, JobCounter* counter, double deltaTime)
+    {
+        SystemNode& current = *_graph[node];
+        GameSystem& system = *_systems[current.system];
+        if (phases & (1u << static_cast<unsigned>(system.GetPhase())))
+        {
+            UpdateSystem(system, deltaTime);
+        }
+
+        for (uint32_t successor : current.successors)
+        {
+            SystemNode& next = *_graph[successor];
+            if (next.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                jobs->Schedule([this, successor, phases, jobs, counter, deltaTime]() {
+                    RunSystem(successor, phases, jobs, counter, deltaTime);
+                }, counter);
+            }
+        }
+    }
+
+    void SystemManager::UpdateSystem(GameSystem& system, double deltaTime)
+    {
+        // Changes made from now on are newer than the version this update starts with.
+        const uint32_t version = _entities.IncrementVersion();
+        system.Update(_entities, deltaTime);
+        system._lastVersion = version;
+    }
+
+    void SystemManager::SetFixedTimestep(double tickRate, uint32_t maxSteps)
+    {
+        _fixedDeltaTime = tickRate > 0.0 ? 1.0 / tickRate : 0.0;
+        _maxFixedSteps = std::max(maxSteps, 1u);
+        _accumulator = 0.0;
+    }
+
     void SystemManager::Update(double deltaTime)
     {
-        for (auto &pair : _systems)
+        const uint32_t allPhases = (1u << static_cast<unsigned>(UpdatePhase::Count)) - 1;
+        if (!IsFixedTimestep())
+        {
+            Run(allPhases, deltaTime);
+            return;
+        }
+
+        _accumulator += deltaTime;
+        _fixedSteps = 0;
+        while (_accumulator >= _fixedDeltaTime && _fixedSteps < _maxFixedSteps)
+        {
+            Update(UpdatePhase::Fixed, _fixedDeltaTime);
+            _accumulator -= _fixedDeltaTime;
+            _fixedSteps++;
+        }
+
+        // Out of budget: drop the backlog so that a slow frame does not make the next ones slower.
+        if (_accumulator >= _fixedDeltaTime)
+        {
+            _accumulator = fmod(_accumulator, _fixedDeltaTime);
+        }
+
+        Update(UpdatePhase::Variable, deltaTime);
+    }
+
+    void SystemManager::Update(UpdatePhase phase, double deltaTime)
+    {
+        Run(1u << static_cast<unsigned>(phase), deltaTime);
+    }
+
+    void SystemManager::Run(uint32_t phases, double deltaTime)
+    {
+        if (_graphDirty)
         {
-            pair.second->Update(_entities, deltaTime);
+            BuildGraph();
         }
+
+        JobSystem* jobs = Object::GetSubsystem<JobSystem>();
+        if (!jobs || jobs->GetWorkerCount() == 0 || _graph.size() < 2)
+        {
+            for (auto& node : _graph)
+            {
+                GameSystem& system = *_systems[node->system];
+                if (phases & (1u << static_cast<unsigned>(system.GetPhase())))
+                {
+                    UpdateSystem(system, deltaTime);
+                }
+            }
+
+            // Deferred and external changes get a version newer than any system update of this frame.
+            _entities.IncrementVersion();
+            _entities.GetCommandBuffer().Playback();
+            return;
+        }
+
+        for (auto& node : _graph)
+        {
+            node->pending.store(node->dependencies, std::memory_order_relaxed);
+        }
+
+        JobCounter counter;
+        const uint32_t count = static_cast<uint32_t>(_graph.size());
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (_graph[i]->dependencies == 0)
+            {
+                jobs->Schedule([this, i, phases, jobs, &counter, deltaTime]() {
+                    RunSystem(i, phases, jobs, &counter, deltaTime);
+                }, &counter);
+            }
+        }
+
+        jobs->Wait(counter);
+
+        // Sync point: apply structural changes deferred by the systems.
+        _entities.IncrementVersion();
+        _entities.GetCommandBuffer().Playback();
     }
 }
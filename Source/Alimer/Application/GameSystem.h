@@ -24,7 +24,10 @@
 
 #include  "../AlimerConfig.h"
 #include  "../Scene/Entity.h"
+#include  <atomic>
+#include  <memory>
 #include  <unordered_map>
+#include  <vector>
 
 namespace Alimer
 {
@@ -42,9 +45,21 @@ namespace Alimer
         static uint32_t ids;
     };
 
+    /// Update phase of a system.
+    enum class UpdatePhase : unsigned
+    {
+        /// Runs at the fixed timestep when enabled, possibly several times per frame.
+        Fixed,
+        /// Runs once per frame with the frame delta.
+        Variable,
+        Count
+    };
+
     /// Defines a base Game System class.
     class ALIMER_API GameSystem : public IntrusivePtrEnabled<GameSystem>
     {
+        friend class SystemManager;
+
     public:
         /// Constructor.
         GameSystem() = default;
@@ -52,8 +67,74 @@ namespace Alimer
         /// Destructor.
         virtual ~GameSystem() = default;
 
+        /// Called on the main thread when added to a SystemManager, before any update. Systems create their
+        /// persistent queries here, as updates may run concurrently with other systems.
+        virtual void Initialize(EntityManager &entities) { ALIMER_UNUSED(entities); }
+
         /// Updates the system
         virtual void Update(EntityManager &entities, double deltaTime) = 0;
+
+        /// Return mask of component families read by the system.
+        const ComponentMask& GetReadMask() const { return _readMask; }
+        /// Return mask of component families written by the system.
+        const ComponentMask& GetWriteMask() const { return _writeMask; }
+        /// Return whether component access was declared. Systems without declarations run exclusively.
+        bool HasDeclaredAccess() const { return _declaredAccess; }
+        /// Return whether this system may not run concurrently with another system.
+        bool ConflictsWith(const GameSystem& other) const;
+
+        /// Return entity change version at the start of the previous update, the threshold for Changed and Added filters.
+        uint32_t GetLastVersion() const { return _lastVersion; }
+
+        /// Return update phase.
+        UpdatePhase GetPhase() const { return _phase; }
+
+    protected:
+        /// Set update phase. Simulation systems use UpdatePhase::Fixed to become independent of the frame rate.
+        void SetPhase(UpdatePhase phase) { _phase = phase; }
+
+        /// Declare read-only access to the given component types.
+        template <typename... Components>
+        void Reads()
+        {
+            _declaredAccess = true;
+            int dummy[] = { 0, (_readMask.set(ComponentIDMapping::GetId<Components>()), 0)... };
+            ALIMER_UNUSED(dummy);
+        }
+
+        /// Declare read-write access to the given component types.
+        template <typename... Components>
+        void Writes()
+        {
+            _declaredAccess = true;
+            int dummy[] = { 0, (_writeMask.set(ComponentIDMapping::GetId<Components>()), 0)... };
+            ALIMER_UNUSED(dummy);
+        }
+
+        /// Require this system to run before system S when both are registered.
+        template <typename S>
+        void RunBefore()
+        {
+            _runBefore.push_back(GameSystemIDMapping::GetId<S>());
+        }
+
+        /// Require this system to run after system S when both are registered.
+        template <typename S>
+        void RunAfter()
+        {
+            _runAfter.push_back(GameSystemIDMapping::GetId<S>());
+        }
+
+    private:
+        /// System type id.
+        uint32_t _id = 0;
+        ComponentMask _readMask;
+        ComponentMask _writeMask;
+        bool _declaredAccess = false;
+        UpdatePhase _phase = UpdatePhase::Variable;
+        uint32_t _lastVersion = 0;
+        std::vector<uint32_t> _runBefore;
+        std::vector<uint32_t> _runAfter;
     };
 
     class ALIMER_API SystemManager final
@@ -71,7 +152,7 @@ namespace Alimer
         template <typename S>
         void Add(const IntrusivePtr<S> system)
         {
-            _systems.insert(std::make_pair(GameSystemIDMapping::GetId<S>(), system));
+            Add(GameSystemIDMapping::GetId<S>(), IntrusivePtr<GameSystem>(system));
         }
 
         /// Creates and add new System.
@@ -84,21 +165,74 @@ namespace Alimer
         }
 
         template <typename S>
-        IntrusivePtr<S> GetSystem()
+        S* GetSystem()
         {
-            auto it = _systems.find(GameSystemIDMapping::GetId<S>());
-            assert(it != _systems.end());
-            return it == _systems.end()
-                ? IntrusivePtr<S>()
-                : IntrusivePtr<S>(std::static_pointer_cast<S>(it->second));
+            auto it = _systemIndices.find(GameSystemIDMapping::GetId<S>());
+            assert(it != _systemIndices.end());
+            return it == _systemIndices.end()
+                ? nullptr
+                : static_cast<S*>(_systems[it->second].Get());
         }
 
-        /// Update all systems.
+        /// Enable fixed timestep for UpdatePhase::Fixed systems at tickRate updates per second, running at most maxSteps
+        /// updates per frame to catch up. Zero tick rate disables it, running every system once per frame.
+        void SetFixedTimestep(double tickRate, uint32_t maxSteps = 5);
+
+        /// Return whether fixed timestep is enabled.
+        bool IsFixedTimestep() const { return _fixedDeltaTime > 0.0; }
+        /// Return fixed update delta time in seconds, zero when disabled.
+        double GetFixedDeltaTime() const { return _fixedDeltaTime; }
+        /// Return number of fixed updates run by the last Update.
+        uint32_t GetFixedStepCount() const { return _fixedSteps; }
+        /// Return fraction of a fixed step accumulated past the last fixed update, for interpolating rendered state.
+        double GetInterpolationAlpha() const { return IsFixedTimestep() ? _accumulator / _fixedDeltaTime : 1.0; }
+
+        /// Update all systems with the frame delta time, then play back the entity command buffer. With fixed timestep
+        /// enabled, fixed phase systems first run once per elapsed tick. Systems without conflicting component access
+        /// run concurrently on the JobSystem.
         void Update(double deltaTime);
 
+        /// Update only the systems of one phase, then play back the entity command buffer.
+        void Update(UpdatePhase phase, double deltaTime);
+
     private:
+        void Add(uint32_t id, const IntrusivePtr<GameSystem>& system);
+        /// Order systems by explicit constraints and build conflict edges.
+        void BuildGraph();
+        /// Update systems whose phase bit is set in phases.
+        void Run(uint32_t phases, double deltaTime);
+        void RunSystem(uint32_t node, uint32_t phases, JobSystem* jobs, JobCounter* counter, double deltaTime);
+        /// Update single system and record its change version.
+        void UpdateSystem(GameSystem& system, double deltaTime);
+
+        struct SystemNode
+        {
+            /// Index into _systems.
+            uint32_t system;
+            /// Number of predecessors.
+            uint32_t dependencies;
+            /// Predecessors still running this frame.
+            std::atomic<uint32_t> pending;
+            /// Nodes that must wait for this one.
+            std::vector<uint32_t> successors;
+        };
+
         EntityManager& _entities;
-        std::unordered_map<uint32_t, IntrusivePtr<GameSystem>> _systems;
+        /// Systems in registration order.
+        std::vector<IntrusivePtr<GameSystem>> _systems;
+        /// Index into _systems by system id.
+        std::unordered_map<uint32_t, uint32_t> _systemIndices;
+        /// Execution graph in topological order.
+        std::vector<std::unique_ptr<SystemNode>> _graph;
+        bool _graphDirty = false;
+        /// Fixed update delta time, zero when disabled.
+        double _fixedDeltaTime = 0.0;
+        /// Maximum fixed updates per frame.
+        uint32_t _maxFixedSteps = 5;
+        /// Fixed updates run by the last Update.
+        uint32_t _fixedSteps = 0;
+        /// Time not yet consumed by fixed updates.
+        double _accumulator = 0.0;
 
         DISALLOW_COPY_MOVE_AND_ASSIGN(SystemManager);
     };
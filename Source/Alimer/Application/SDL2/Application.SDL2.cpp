@@ -213,6 +213,8 @@ namespace Alimer
             RunFrame();
         }
 
+        // Finish the frame still in flight on the render thread.
+        _framePipeline.Stop();
         OnExiting();
 
         // quit all subsystems and quit application.
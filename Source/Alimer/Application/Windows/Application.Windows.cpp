@@ -184,6 +184,8 @@ namespace Alimer
             RunFrame();
         }
 
+        // Finish the frame still in flight on the render thread.
+        _framePipeline.Stop();
         OnExiting();
 
         return EXIT_SUCCESS;
@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Base/FrameAllocator.h"
+#include <algorithm>
+#include <cstdlib>
+using namespace std;
+
+namespace Alimer
+{
+    /// Size of the blocks threads carve small allocations from.
+    static constexpr size_t FRAME_THREAD_BLOCK_SIZE = 4 * 1024;
+
+    /// Allocations up to this size are served from the thread block.
+    static constexpr size_t FRAME_THREAD_ALLOCATION_SIZE = 512;
+
+    /// Source of frame stamps, unique across allocators.
+    static atomic<uint64_t> s_nextEpoch{ 1 };
+
+    /// Block owned by the calling thread for the frame stamped with epoch.
+    struct FrameThreadBlock
+    {
+        uint64_t epoch = 0;
+        uint8_t* cursor = nullptr;
+        uint8_t* end = nullptr;
+    };
+
+    static thread_local FrameThreadBlock s_threadBlock;
+
+    static inline uint8_t* AlignUp(uint8_t* ptr, size_t alignment)
+    {
+        return reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(ptr) + alignment - 1) & ~(uintptr_t(alignment) - 1));
+    }
+
+    FrameAllocator::FrameAllocator(size_t frameCapacity, uint32_t frameCount)
+        : _epoch(s_nextEpoch.fetch_add(1, memory_order_relaxed))
+    {
+        frameCount = std::max(frameCount, 1u);
+        _frames.reserve(frameCount);
+        for (uint32_t i = 0; i < frameCount; ++i)
+        {
+            unique_ptr<Frame> frame(new Frame());
+            frame->capacity = frameCapacity;
+            frame->data = static_cast<uint8_t*>(malloc(frameCapacity));
+            _frames.push_back(std::move(frame));
+        }
+    }
+
+    FrameAllocator::~FrameAllocator()
+    {
+        for (auto& frame : _frames)
+        {
+            Recycle(*frame);
+            free(frame->data);
+        }
+    }
+
+    void FrameAllocator::NextFrame()
+    {
+        const FrameAllocatorStats stats = GetStats();
+        _peak = std::max(_peak, stats.used);
+
+        _current = (_current + 1) % GetFrameCount();
+        _epoch = s_nextEpoch.fetch_add(1, memory_order_relaxed);
+        Recycle(*_frames[_current]);
+    }
+
+    void* FrameAllocator::Allocate(size_t size, size_t alignment)
+    {
+        Frame& frame = *_frames[_current];
+        if (size > FRAME_THREAD_ALLOCATION_SIZE || alignment > FRAME_THREAD_ALLOCATION_SIZE)
+        {
+            return AllocateShared(frame, size, alignment);
+        }
+
+        FrameThreadBlock& block = s_threadBlock;
+        if (block.epoch == _epoch)
+        {
+            uint8_t* ptr = AlignUp(block.cursor, alignment);
+            if (ptr + size <= block.end)
+            {
+                block.cursor = ptr + size;
+                return ptr;
+            }
+        }
+
+        // Refill the thread block, the rest of the previous one is wasted.
+        block.epoch = _epoch;
+        block.cursor = AllocateShared(frame, FRAME_THREAD_BLOCK_SIZE, alignof(std::max_align_t));
+        block.end = block.cursor + FRAME_THREAD_BLOCK_SIZE;
+
+        uint8_t* ptr = AlignUp(block.cursor, alignment);
+        block.cursor = ptr + size;
+        return ptr;
+    }
+
+    uint8_t* FrameAllocator::AllocateShared(Frame& frame, size_t size, size_t alignment)
+    {
+        // Reserving alignment - 1 extra bytes makes the aligned block fit regardless of the offset.
+        const size_t reserved = size + alignment - 1;
+        const size_t offset = frame.offset.fetch_add(reserved, memory_order_relaxed);
+        if (offset + reserved <= frame.capacity)
+        {
+            return AlignUp(frame.data + offset, alignment);
+        }
+
+        uint8_t* ptr = static_cast<uint8_t*>(malloc(reserved));
+        frame.overflowSize.fetch_add(reserved, memory_order_relaxed);
+        {
+            lock_guard<mutex> lock(_overflowMutex);
+            frame.overflow.push_back(ptr);
+        }
+        return AlignUp(ptr, alignment);
+    }
+
+    void FrameAllocator::Recycle(Frame& frame)
+    {
+        const size_t overflowSize = frame.overflowSize.load(memory_order_relaxed);
+        for (void* ptr : frame.overflow)
+        {
+            free(ptr);
+        }
+        frame.overflow.clear();
+
+        // Grow to the observed peak, so that steady state frames never reach the heap.
+        if (overflowSize)
+        {
+            const size_t used = std::min(frame.offset.load(memory_order_relaxed), frame.capacity) + overflowSize;
+            frame.capacity = std::max(frame.capacity * 2, used + used / 4);
+            free(frame.data);
+            frame.data = static_cast<uint8_t*>(malloc(frame.capacity));
+        }
+
+        frame.offset.store(0, memory_order_relaxed);
+        frame.overflowSize.store(0, memory_order_relaxed);
+    }
+
+    FrameAllocatorStats FrameAllocator::GetStats() const
+    {
+        const Frame& frame = *_frames[_current];
+        FrameAllocatorStats stats;
+        stats.capacity = frame.capacity;
+        stats.overflow = frame.overflowSize.load(memory_order_relaxed);
+        stats.used = std::min(frame.offset.load(memory_order_relaxed), frame.capacity) + stats.overflow;
+        stats.peak = std::max(_peak, stats.used);
+        {
+            lock_guard<mutex> lock(_overflowMutex);
+            stats.overflowCount = static_cast<uint32_t>(frame.overflow.size());
+        }
+        return stats;
+    }
+}
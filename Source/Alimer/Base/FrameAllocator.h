@@ -0,0 +1,179 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../AlimerConfig.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace Alimer
+{
+    /// Frame allocator usage statistics in bytes.
+    struct FrameAllocatorStats
+    {
+        /// Arena capacity of the current frame.
+        size_t capacity;
+        /// Bytes handed out in the current frame, including overflow.
+        size_t used;
+        /// Highest per frame usage since construction or ResetPeak.
+        size_t peak;
+        /// Bytes served from the heap in the current frame because the arena was full.
+        size_t overflow;
+        /// Heap allocations made in the current frame because the arena was full.
+        uint32_t overflowCount;
+    };
+
+    /// Linear allocator for memory that lives at most a few frames. Every frame bumps a pointer through its own arena;
+    /// the ring of frameCount arenas is recycled by NextFrame, so memory allocated in frame N stays valid until frame
+    /// N + frameCount begins. Threads carve small allocations from private blocks, large ones bump the shared arena
+    /// atomically. When the arena is exhausted allocations fall back to the heap and the arena grows to the observed
+    /// peak when it is recycled. Deallocation is a no-op and destructors are never run.
+    class ALIMER_API FrameAllocator final
+    {
+    public:
+        /// Constructor.
+        explicit FrameAllocator(size_t frameCapacity = 4 * 1024 * 1024, uint32_t frameCount = 3);
+
+        /// Destructor.
+        ~FrameAllocator();
+
+        /// Advance to the next frame, recycling the arena of frameCount frames ago. Must not run concurrently with Allocate.
+        void NextFrame();
+
+        /// Allocate memory valid for frameCount frames. Safe to call concurrently.
+        void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        /// Allocate uninitialized array of count elements.
+        template <typename T>
+        T* AllocateArray(size_t count)
+        {
+            return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+        }
+
+        /// Construct object. Its destructor is never called.
+        template <typename T, typename... Args>
+        T* New(Args&&... args)
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "Frame allocated objects are never destroyed.");
+            return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        /// Return number of frames memory stays valid for.
+        uint32_t GetFrameCount() const { return static_cast<uint32_t>(_frames.size()); }
+
+        /// Return usage statistics.
+        FrameAllocatorStats GetStats() const;
+
+        /// Restart peak usage tracking.
+        void ResetPeak() { _peak = 0; }
+
+    private:
+        struct Frame
+        {
+            uint8_t* data = nullptr;
+            size_t capacity = 0;
+            /// Bump offset, may run past capacity.
+            std::atomic<size_t> offset{ 0 };
+            /// Heap fallback allocations.
+            std::vector<void*> overflow;
+            std::atomic<size_t> overflowSize{ 0 };
+        };
+
+        /// Bump the shared arena, falling back to the heap. Returns block of at least size bytes.
+        uint8_t* AllocateShared(Frame& frame, size_t size, size_t alignment);
+        /// Release heap fallback allocations and grow the arena when it overflowed.
+        void Recycle(Frame& frame);
+
+        std::vector<std::unique_ptr<Frame>> _frames;
+        /// Index of the current frame in the ring.
+        uint32_t _current = 0;
+        /// Unique stamp of the current frame, invalidates thread blocks of earlier frames and other allocators.
+        uint64_t _epoch;
+        size_t _peak = 0;
+        /// Guards heap fallback lists.
+        mutable std::mutex _overflowMutex;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(FrameAllocator);
+    };
+
+    /// STL allocator adapter allocating from a FrameAllocator. Containers using it must not outlive the frame ring.
+    /// A default constructed adapter allocates from the heap, so containers can be members rebound to a frame later.
+    /// The adapter propagates on assignment and swap: assigning a container bound to the current frame rebinds the target.
+    template <typename T>
+    class FrameStlAllocator
+    {
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        FrameStlAllocator() noexcept = default;
+
+        FrameStlAllocator(FrameAllocator* allocator) noexcept
+            : _allocator(allocator)
+        {
+        }
+
+        template <typename U>
+        FrameStlAllocator(const FrameStlAllocator<U>& other) noexcept
+            : _allocator(other.GetAllocator())
+        {
+        }
+
+        T* allocate(size_t count)
+        {
+            return _allocator ? _allocator->AllocateArray<T>(count) : static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+
+        void deallocate(T* ptr, size_t count) noexcept
+        {
+            ALIMER_UNUSED(count);
+            if (!_allocator)
+            {
+                ::operator delete(ptr);
+            }
+        }
+
+        FrameAllocator* GetAllocator() const { return _allocator; }
+
+        template <typename U>
+        bool operator ==(const FrameStlAllocator<U>& other) const { return _allocator == other.GetAllocator(); }
+
+        template <typename U>
+        bool operator !=(const FrameStlAllocator<U>& other) const { return _allocator != other.GetAllocator(); }
+
+    private:
+        FrameAllocator* _allocator = nullptr;
+    };
+
+    /// Vector allocated from a FrameAllocator. Reserve up front: buffers left behind by growth are only reclaimed with the frame.
+    template <typename T>
+    using FrameVector = std::vector<T, FrameStlAllocator<T>>;
+}
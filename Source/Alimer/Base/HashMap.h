@@ -22,10 +22,20 @@
 
 #pragma once
 
+#include "../Math/MathUtil.h"
+#include <algorithm>
 #include <memory>
+#include <new>
 #include <stdint.h>
-#include <unordered_map>
+#include <stdlib.h>
+#include <string.h>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#if ALIMER_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace Util
 {
@@ -39,8 +49,651 @@ namespace Util
         }
     };
 
+    namespace Internal
+    {
+        // Control byte of an unused slot. Used slots store the low 7 bits of the hash, so the sign tells them apart.
+        static const int8_t CONTROL_EMPTY = -128;
+        // Control byte of an erased slot, probing continues past it.
+        static const int8_t CONTROL_DELETED = -2;
+
+        // Sixteen control bytes probed together.
+        struct ControlGroup
+        {
+            static const size_t size = 16;
+
+#if ALIMER_SSE2
+            explicit ControlGroup(const int8_t *control)
+                : bytes(_mm_load_si128(reinterpret_cast<const __m128i *>(control)))
+            {
+            }
+
+            // Return bit mask of slots whose control byte equals value.
+            uint32_t match(int8_t value) const
+            {
+                return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(value))));
+            }
+
+            uint32_t match_empty() const
+            {
+                return match(CONTROL_EMPTY);
+            }
+
+            // Return bit mask of slots free for insertion.
+            uint32_t match_free() const
+            {
+                return uint32_t(_mm_movemask_epi8(bytes));
+            }
+
+            __m128i bytes;
+#else
+            explicit ControlGroup(const int8_t *control)
+                : bytes(control)
+            {
+            }
+
+            uint32_t match(int8_t value) const
+            {
+                uint32_t mask = 0;
+                for (size_t i = 0; i < size; i++)
+                    mask |= uint32_t(bytes[i] == value) << i;
+                return mask;
+            }
+
+            uint32_t match_empty() const
+            {
+                return match(CONTROL_EMPTY);
+            }
+
+            uint32_t match_free() const
+            {
+                uint32_t mask = 0;
+                for (size_t i = 0; i < size; i++)
+                    mask |= uint32_t(bytes[i] < 0) << i;
+                return mask;
+            }
+
+            const int8_t *bytes;
+#endif
+        };
+    }
+
+    // Flat open-addressing map keyed by precomputed hashes, in the style of Swiss tables.
+    // Slots are stored in one array next to one control byte each; lookups compare 16 control bytes
+    // at once and only touch slots whose 7 bit hash tag matches. No allocation per entry.
+    // Unlike std::unordered_map, insertion and erasure invalidate iterators and references.
     template <typename T>
-    using HashMap = std::unordered_map<Hash, T, UnityHasher>;
+    class HashMap
+    {
+    public:
+        using key_type = Hash;
+        using mapped_type = T;
+        using value_type = std::pair<const Hash, T>;
+
+        template <bool Const>
+        class Iterator
+        {
+        public:
+            using Map = typename std::conditional<Const, const HashMap, HashMap>::type;
+            using Value = typename std::conditional<Const, const value_type, value_type>::type;
+
+            Iterator() = default;
+
+            Iterator(Map *map, size_t index)
+                : map(map), index(index)
+            {
+                skip();
+            }
+
+            // Allow conversion of iterator to const_iterator.
+            template <bool OtherConst, typename = typename std::enable_if<Const && !OtherConst>::type>
+            Iterator(const Iterator<OtherConst> &other)
+                : map(other.map), index(other.index)
+            {
+            }
+
+            Value &operator*() const
+            {
+                return map->slots[index];
+            }
+
+            Value *operator->() const
+            {
+                return &map->slots[index];
+            }
+
+            Iterator &operator++()
+            {
+                index++;
+                skip();
+                return *this;
+            }
+
+            Iterator operator++(int)
+            {
+                Iterator result = *this;
+                ++*this;
+                return result;
+            }
+
+            bool operator==(const Iterator &other) const
+            {
+                return index == other.index;
+            }
+
+            bool operator!=(const Iterator &other) const
+            {
+                return index != other.index;
+            }
+
+        private:
+            friend class HashMap;
+            template <bool> friend class Iterator;
+
+            void skip()
+            {
+                while (index < map->capacity && map->control[index] < 0)
+                    index++;
+            }
+
+            Map *map = nullptr;
+            size_t index = 0;
+        };
+
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        HashMap() = default;
+
+        HashMap(const HashMap &other)
+        {
+            *this = other;
+        }
+
+        HashMap(HashMap &&other) noexcept
+        {
+            swap(other);
+        }
+
+        ~HashMap()
+        {
+            destroy();
+        }
+
+        HashMap &operator=(const HashMap &other)
+        {
+            if (this != &other)
+            {
+                clear();
+                reserve(other.element_count);
+                for (auto &value : other)
+                    emplace(value.first, value.second);
+            }
+            return *this;
+        }
+
+        HashMap &operator=(HashMap &&other) noexcept
+        {
+            if (this != &other)
+            {
+                destroy();
+                swap(other);
+            }
+            return *this;
+        }
+
+        iterator begin()
+        {
+            return iterator(this, 0);
+        }
+
+        iterator end()
+        {
+            return iterator(this, capacity);
+        }
+
+        const_iterator begin() const
+        {
+            return const_iterator(this, 0);
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator(this, capacity);
+        }
+
+        size_t size() const
+        {
+            return element_count;
+        }
+
+        bool empty() const
+        {
+            return element_count == 0;
+        }
+
+        // Destroy all entries, keeping the slot array.
+        void clear()
+        {
+            for (size_t i = 0; i < capacity; i++)
+            {
+                if (control[i] >= 0)
+                    slots[i].~value_type();
+            }
+
+            if (capacity)
+                memset(control, Internal::CONTROL_EMPTY, capacity);
+            element_count = 0;
+            growth_left = max_load(capacity);
+        }
+
+        // Make room for n entries without rehashing.
+        void reserve(size_t n)
+        {
+            size_t new_capacity = Internal::ControlGroup::size;
+            while (max_load(new_capacity) < n)
+                new_capacity *= 2;
+
+            if (new_capacity > capacity)
+                rehash(new_capacity);
+        }
+
+        iterator find(Hash key)
+        {
+            return iterator(this, find_index(key));
+        }
+
+        const_iterator find(Hash key) const
+        {
+            return const_iterator(this, find_index(key));
+        }
+
+        size_t count(Hash key) const
+        {
+            return find_index(key) != capacity ? 1 : 0;
+        }
+
+        T &operator[](Hash key)
+        {
+            return emplace(key).first->second;
+        }
+
+        std::pair<iterator, bool> insert(const value_type &value)
+        {
+            return emplace(value.first, value.second);
+        }
+
+        // Construct value from args unless key is present.
+        template <typename... P>
+        std::pair<iterator, bool> emplace(Hash key, P &&... p)
+        {
+            size_t index = find_index(key);
+            if (index != capacity)
+                return std::make_pair(iterator(this, index), false);
+
+            index = prepare_insert(key);
+            new(&slots[index]) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<P>(p)...));
+            element_count++;
+            return std::make_pair(iterator(this, index), true);
+        }
+
+        size_t erase(Hash key)
+        {
+            const size_t index = find_index(key);
+            if (index == capacity)
+                return 0;
+
+            erase_index(index);
+            return 1;
+        }
+
+        iterator erase(const_iterator position)
+        {
+            erase_index(position.index);
+            return iterator(this, position.index + 1);
+        }
+
+        void swap(HashMap &other) noexcept
+        {
+            std::swap(control, other.control);
+            std::swap(slots, other.slots);
+            std::swap(capacity, other.capacity);
+            std::swap(element_count, other.element_count);
+            std::swap(growth_left, other.growth_left);
+        }
+
+    private:
+        // Keep the table at most 7/8 full.
+        static size_t max_load(size_t n)
+        {
+            return n - n / 8;
+        }
+
+        // Spread key bits, the low 7 bits become the slot tag and the rest select the group.
+        static uint64_t mix(Hash key)
+        {
+            const uint64_t h = key * 0x9e3779b97f4a7c15ull;
+            return h ^ (h >> 32);
+        }
+
+        size_t group_mask() const
+        {
+            return capacity / Internal::ControlGroup::size - 1;
+        }
+
+        size_t find_index(Hash key) const
+        {
+            if (!element_count)
+                return capacity;
+
+            const uint64_t h = mix(key);
+            const int8_t tag = int8_t(h & 0x7f);
+            size_t group = size_t(h >> 7) & group_mask();
+            for (size_t step = 1;; step++)
+            {
+                const size_t base = group * Internal::ControlGroup::size;
+                const Internal::ControlGroup g(control + base);
+                for (uint32_t mask = g.match(tag); mask; mask &= mask - 1)
+                {
+                    const size_t index = base + Alimer::ScanForward(mask);
+                    if (slots[index].first == key)
+                        return index;
+                }
+
+                if (g.match_empty())
+                    return capacity;
+
+                // Triangular probing visits every group of a power of two table.
+                group = (group + step) & group_mask();
+            }
+        }
+
+        // Return free slot for key, growing when needed, with its control byte set.
+        size_t prepare_insert(Hash key)
+        {
+            if (growth_left == 0)
+                rehash(capacity ? (element_count * 2 < max_load(capacity) ? capacity : capacity * 2) : Internal::ControlGroup::size);
+
+            const size_t index = find_free(key);
+            if (control[index] == Internal::CONTROL_EMPTY)
+                growth_left--;
+
+            control[index] = int8_t(mix(key) & 0x7f);
+            return index;
+        }
+
+        size_t find_free(Hash key) const
+        {
+            size_t group = size_t(mix(key) >> 7) & group_mask();
+            for (size_t step = 1;; step++)
+            {
+                const size_t base = group * Internal::ControlGroup::size;
+                const uint32_t mask = Internal::ControlGroup(control + base).match_free();
+                if (mask)
+                    return base + Alimer::ScanForward(mask);
+
+                group = (group + step) & group_mask();
+            }
+        }
+
+        void erase_index(size_t index)
+        {
+            slots[index].~value_type();
+            element_count--;
+
+            // Probing stops at groups with an empty slot, so one more empty slot there cannot cut a probe sequence short.
+            const size_t base = index & ~(Internal::ControlGroup::size - 1);
+            if (Internal::ControlGroup(control + base).match_empty())
+            {
+                control[index] = Internal::CONTROL_EMPTY;
+                growth_left++;
+            }
+            else
+            {
+                control[index] = Internal::CONTROL_DELETED;
+            }
+        }
+
+        void rehash(size_t new_capacity)
+        {
+            int8_t *old_control = control;
+            value_type *old_slots = slots;
+            const size_t old_capacity = capacity;
+
+            // Control bytes are loaded 16 at a time with aligned loads.
+            control = static_cast<int8_t *>(aligned_alloc_bytes(new_capacity));
+            slots = static_cast<value_type *>(malloc(new_capacity * sizeof(value_type)));
+            memset(control, Internal::CONTROL_EMPTY, new_capacity);
+            capacity = new_capacity;
+            growth_left = max_load(new_capacity) - element_count;
+
+            for (size_t i = 0; i < old_capacity; i++)
+            {
+                if (old_control[i] < 0)
+                    continue;
+
+                const size_t index = find_free(old_slots[i].first);
+                control[index] = old_control[i];
+                new(&slots[index]) value_type(std::move(old_slots[i]));
+                old_slots[i].~value_type();
+            }
+
+            aligned_free_bytes(old_control);
+            ::free(old_slots);
+        }
+
+        void destroy()
+        {
+            clear();
+            aligned_free_bytes(control);
+            ::free(slots);
+            control = nullptr;
+            slots = nullptr;
+            capacity = 0;
+            growth_left = 0;
+        }
+
+        static void *aligned_alloc_bytes(size_t size)
+        {
+            // Store the offset in front of the aligned block.
+            uint8_t *memory = static_cast<uint8_t *>(malloc(size + Internal::ControlGroup::size));
+            const size_t offset = Internal::ControlGroup::size - (reinterpret_cast<uintptr_t>(memory) & (Internal::ControlGroup::size - 1));
+            memory[offset - 1] = uint8_t(offset);
+            return memory + offset;
+        }
+
+        static void aligned_free_bytes(void *ptr)
+        {
+            if (!ptr)
+                return;
+
+            uint8_t *bytes = static_cast<uint8_t *>(ptr);
+            ::free(bytes - bytes[-1]);
+        }
+
+        int8_t *control = nullptr;
+        value_type *slots = nullptr;
+        size_t capacity = 0;
+        size_t element_count = 0;
+        size_t growth_left = 0;
+    };
+
+    namespace Internal
+    {
+        // Secrets of wyhash, odd with balanced bit counts.
+        static const uint64_t HASH_SECRET0 = 0xa0761d6478bd642full;
+        static const uint64_t HASH_SECRET1 = 0xe7037ed1a0b428dbull;
+        static const uint64_t HASH_SECRET2 = 0x8ebc6af09c88c6e3ull;
+        static const uint64_t HASH_SECRET3 = 0x589965cc75374cc3ull;
+
+        // Bytes consumed per block, two independent 16 byte lanes.
+        static const size_t HASH_BLOCK_SIZE = 32;
+
+        // Full 64x64 -> 128 bit multiply, folding the high half into the low one.
+        inline uint64_t hash_mix(uint64_t a, uint64_t b)
+        {
+#if defined(__SIZEOF_INT128__)
+            const __uint128_t r = __uint128_t(a) * b;
+            return uint64_t(r) ^ uint64_t(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            uint64_t high;
+            const uint64_t low = _umul128(a, b, &high);
+            return low ^ high;
+#else
+            const uint64_t a_low = a & 0xffffffffu, a_high = a >> 32;
+            const uint64_t b_low = b & 0xffffffffu, b_high = b >> 32;
+            const uint64_t low_low = a_low * b_low;
+            const uint64_t high_low = a_high * b_low;
+            const uint64_t low_high = a_low * b_high;
+            const uint64_t high_high = a_high * b_high;
+            const uint64_t cross = (low_low >> 32) + (high_low & 0xffffffffu) + low_high;
+            const uint64_t low = (cross << 32) | (low_low & 0xffffffffu);
+            const uint64_t high = high_high + (high_low >> 32) + (cross >> 32);
+            return low ^ high;
+#endif
+        }
+
+        // Unaligned little endian reads.
+        inline uint64_t hash_read64(const uint8_t *p)
+        {
+            uint64_t v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        inline uint64_t hash_read32(const uint8_t *p)
+        {
+            uint32_t v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        struct HashLanes
+        {
+            explicit HashLanes(Hash seed)
+            {
+                lane0 = seed ^ hash_mix(seed ^ HASH_SECRET0, HASH_SECRET1);
+                lane1 = lane0;
+            }
+
+            // Consume one 32 byte block. The lanes form independent multiply chains.
+            inline void block(const uint8_t *p)
+            {
+                lane0 = hash_mix(hash_read64(p) ^ HASH_SECRET1, hash_read64(p + 8) ^ lane0);
+                lane1 = hash_mix(hash_read64(p + 16) ^ HASH_SECRET2, hash_read64(p + 24) ^ lane1);
+            }
+
+            // Combine the last 0 to 32 bytes and the total size into the final hash.
+            inline Hash finish(const uint8_t *p, size_t size, uint64_t total) const
+            {
+                uint64_t l0 = lane0;
+                uint64_t a, b;
+                if (size <= 16)
+                {
+                    if (size >= 4)
+                    {
+                        // Two overlapping pairs of 32 bit reads cover 4 to 16 bytes.
+                        const size_t offset = (size >> 3) << 2;
+                        a = (hash_read32(p) << 32) | hash_read32(p + offset);
+                        b = (hash_read32(p + size - 4) << 32) | hash_read32(p + size - 4 - offset);
+                    }
+                    else if (size > 0)
+                    {
+                        a = (uint64_t(p[0]) << 16) | (uint64_t(p[size >> 1]) << 8) | p[size - 1];
+                        b = 0;
+                    }
+                    else
+                    {
+                        a = 0;
+                        b = 0;
+                    }
+                }
+                else
+                {
+                    l0 = hash_mix(hash_read64(p) ^ HASH_SECRET1, hash_read64(p + 8) ^ l0);
+                    a = hash_read64(p + size - 16);
+                    b = hash_read64(p + size - 8);
+                }
+
+                return hash_mix(HASH_SECRET1 ^ total, hash_mix(a ^ HASH_SECRET1, b ^ l0 ^ lane1 ^ HASH_SECRET3));
+            }
+
+            uint64_t lane0;
+            uint64_t lane1;
+        };
+    }
+
+    // Hash a block of memory, wyhash style. Consumes 32 bytes per step on two independent lanes.
+    inline Hash hash_bytes(const void *data, size_t size, Hash seed = 0)
+    {
+        const uint8_t *p = static_cast<const uint8_t *>(data);
+        Internal::HashLanes lanes(seed);
+
+        // Keep the last 1 to 32 bytes for finish(), so that StreamHasher produces the same value.
+        size_t remaining = size;
+        while (remaining > Internal::HASH_BLOCK_SIZE)
+        {
+            lanes.block(p);
+            p += Internal::HASH_BLOCK_SIZE;
+            remaining -= Internal::HASH_BLOCK_SIZE;
+        }
+
+        return lanes.finish(p, remaining, size);
+    }
+
+    // Incremental hash_bytes() for blobs which are not in memory at once.
+    // Feeding the same bytes in any number of update() calls gives the same value as hash_bytes().
+    class StreamHasher
+    {
+    public:
+        explicit StreamHasher(Hash seed = 0)
+            : lanes(seed)
+        {
+        }
+
+        void update(const void *data, size_t size)
+        {
+            const uint8_t *p = static_cast<const uint8_t *>(data);
+            total += size;
+
+            if (buffered)
+            {
+                // Complete the buffered block, only consuming it once more data follows.
+                const size_t copy = std::min(size, Internal::HASH_BLOCK_SIZE - buffered);
+                memcpy(buffer + buffered, p, copy);
+                buffered += copy;
+                p += copy;
+                size -= copy;
+
+                if (!size)
+                    return;
+
+                lanes.block(buffer);
+                buffered = 0;
+            }
+
+            while (size > Internal::HASH_BLOCK_SIZE)
+            {
+                lanes.block(p);
+                p += Internal::HASH_BLOCK_SIZE;
+                size -= Internal::HASH_BLOCK_SIZE;
+            }
+
+            memcpy(buffer, p, size);
+            buffered = size;
+        }
+
+        // Hash of all bytes so far. Further updates may follow.
+        Hash get() const
+        {
+            return lanes.finish(buffer, buffered, total);
+        }
+
+    private:
+        Internal::HashLanes lanes;
+        uint8_t buffer[Internal::HASH_BLOCK_SIZE];
+        size_t buffered = 0;
+        uint64_t total = 0;
+    };
 
     class Hasher
     {
@@ -52,17 +705,22 @@ namespace Util
 
         Hasher() = default;
 
+        // Hash size bytes of data.
         template <typename T>
         inline void data(const T *data, size_t size)
         {
-            size /= sizeof(*data);
-            for (size_t i = 0; i < size; i++)
-                h = (h * 0x100000001b3ull) ^ data[i];
+            h = hash_bytes(data, size, h);
+        }
+
+        // Fold in the result of a stream.
+        inline void stream(const StreamHasher &stream)
+        {
+            u64(stream.get());
         }
 
         inline void u32(uint32_t value)
         {
-            h = (h * 0x100000001b3ull) ^ value;
+            h = Internal::hash_mix(h ^ Internal::HASH_SECRET0, value ^ Internal::HASH_SECRET1);
         }
 
         inline void s32(int32_t value)
@@ -83,8 +741,7 @@ namespace Util
 
         inline void u64(uint64_t value)
         {
-            u32(value & 0xffffffffu);
-            u32(value >> 32);
+            h = Internal::hash_mix(h ^ Internal::HASH_SECRET0, value ^ Internal::HASH_SECRET2);
         }
 
         template <typename T>
@@ -95,17 +752,12 @@ namespace Util
 
         inline void string(const char *str)
         {
-            char c;
-            u32(0xff);
-            while ((c = *str++) != '\0')
-                u32(uint8_t(c));
+            data(str, strlen(str));
         }
 
         inline void string(const std::string &str)
         {
-            u32(0xff);
-            for (auto &c : str)
-                u32(uint8_t(c));
+            data(str.data(), str.size());
         }
 
         inline Hash get() const
@@ -0,0 +1,194 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Base/Name.h"
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+using namespace std;
+
+namespace Alimer
+{
+    /// Log2 of the number of independently locked parts of the table.
+    static constexpr uint32_t NAME_SHARD_BITS = 4;
+    static constexpr size_t NAME_SHARD_COUNT = size_t(1) << NAME_SHARD_BITS;
+
+    /// Size of the arena blocks entries are carved from. Longer strings get a block of their own.
+    static constexpr size_t NAME_BLOCK_SIZE = 64 * 1024;
+
+    namespace
+    {
+        class NameShard
+        {
+        public:
+            NameShard() = default;
+
+            ~NameShard()
+            {
+                for (void* block : _blocks)
+                {
+                    free(block);
+                }
+            }
+
+            const Name::Entry* Find(Util::Hash hash, const char* str, uint32_t length) const
+            {
+                auto it = _entries.find(hash);
+                if (it == _entries.end())
+                    return nullptr;
+
+                for (const Name::Entry* entry = it->second; entry; entry = entry->next)
+                {
+                    if (entry->length == length && memcmp(entry->data, str, length) == 0)
+                        return entry;
+                }
+
+                return nullptr;
+            }
+
+            const Name::Entry* Insert(Util::Hash hash, const char* str, uint32_t length)
+            {
+                Name::Entry* entry = static_cast<Name::Entry*>(Allocate(offsetof(Name::Entry, data) + length + 1));
+                entry->hash = hash;
+                entry->length = length;
+                memcpy(entry->data, str, length);
+                entry->data[length] = '\0';
+
+                Name::Entry*& head = _entries[hash];
+                entry->next = head;
+                head = entry;
+                _count++;
+                return entry;
+            }
+
+            mutable mutex _mutex;
+            size_t _count = 0;
+            size_t _memoryUsage = 0;
+
+        private:
+            void* Allocate(size_t size)
+            {
+                size = (size + alignof(Name::Entry) - 1) & ~(alignof(Name::Entry) - 1);
+                if (size > NAME_BLOCK_SIZE / 4)
+                {
+                    void* block = malloc(size);
+                    _blocks.push_back(block);
+                    _memoryUsage += size;
+                    return block;
+                }
+
+                if (_blockOffset + size > NAME_BLOCK_SIZE || !_block)
+                {
+                    _block = static_cast<uint8_t*>(malloc(NAME_BLOCK_SIZE));
+                    _blocks.push_back(_block);
+                    _blockOffset = 0;
+                }
+
+                void* result = _block + _blockOffset;
+                _blockOffset += size;
+                _memoryUsage += size;
+                return result;
+            }
+
+            /// First entry of each hash chain.
+            Util::HashMap<Name::Entry*> _entries;
+            std::vector<void*> _blocks;
+            uint8_t* _block = nullptr;
+            size_t _blockOffset = 0;
+
+            DISALLOW_COPY_MOVE_AND_ASSIGN(NameShard);
+        };
+
+        NameShard* GetShards()
+        {
+            static NameShard shards[NAME_SHARD_COUNT];
+            return shards;
+        }
+
+        NameShard& GetShard(Util::Hash hash)
+        {
+            // The low bits select the hash map group, take the shard from the top ones.
+            return GetShards()[hash >> (64 - NAME_SHARD_BITS)];
+        }
+    }
+
+    Name::Name(const char* str)
+        : Name(str, str ? static_cast<uint32_t>(strlen(str)) : 0)
+    {
+    }
+
+    Name::Name(const String& str)
+        : Name(str.CString(), str.Length())
+    {
+    }
+
+    Name::Name(const char* str, uint32_t length)
+    {
+        if (!length)
+            return;
+
+        const Util::Hash hash = Util::hash_bytes(str, length);
+        NameShard& shard = GetShard(hash);
+        lock_guard<mutex> lock(shard._mutex);
+        _entry = shard.Find(hash, str, length);
+        if (!_entry)
+        {
+            _entry = shard.Insert(hash, str, length);
+        }
+    }
+
+    Name Name::Find(const char* str, uint32_t length)
+    {
+        if (!length)
+            return Name();
+
+        const Util::Hash hash = Util::hash_bytes(str, length);
+        NameShard& shard = GetShard(hash);
+        lock_guard<mutex> lock(shard._mutex);
+        return Name(shard.Find(hash, str, length));
+    }
+
+    size_t Name::GetCount()
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < NAME_SHARD_COUNT; ++i)
+        {
+            NameShard& shard = GetShards()[i];
+            lock_guard<mutex> lock(shard._mutex);
+            count += shard._count;
+        }
+        return count;
+    }
+
+    size_t Name::GetMemoryUsage()
+    {
+        size_t memoryUsage = 0;
+        for (size_t i = 0; i < NAME_SHARD_COUNT; ++i)
+        {
+            NameShard& shard = GetShards()[i];
+            lock_guard<mutex> lock(shard._mutex);
+            memoryUsage += shard._memoryUsage;
+        }
+        return memoryUsage;
+    }
+}
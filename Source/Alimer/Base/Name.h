@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Base/String.h"
+#include "../Base/HashMap.h"
+
+namespace Alimer
+{
+    /// Interned string. Every distinct string is stored once in a global table and a Name is a pointer to that entry,
+    /// so copies are free, equality is a pointer compare and the hash is computed only when the string is interned.
+    /// Entries live until the process exits. Safe to construct from any thread.
+    class ALIMER_API Name
+    {
+    public:
+        /// Construct empty.
+        Name() noexcept = default;
+
+        /// Construct from a C string.
+        Name(const char* str); // NOLINT(google-explicit-constructor)
+
+        /// Construct from a character range.
+        Name(const char* str, uint32_t length);
+
+        /// Construct from a string.
+        Name(const String& str); // NOLINT(google-explicit-constructor)
+
+        /// Test for equality with another name.
+        bool operator ==(const Name& rhs) const { return _entry == rhs._entry; }
+        /// Test for inequality with another name.
+        bool operator !=(const Name& rhs) const { return _entry != rhs._entry; }
+        /// Order by entry address. Stable while the process runs, unrelated to alphabetical order.
+        bool operator <(const Name& rhs) const { return _entry < rhs._entry; }
+
+        /// Return whether the name is empty.
+        bool IsEmpty() const { return _entry == nullptr; }
+        /// Return null terminated characters.
+        const char* CString() const { return _entry ? _entry->data : ""; }
+        /// Return length in characters.
+        uint32_t Length() const { return _entry ? _entry->length : 0; }
+        /// Return case-sensitive 64-bit hash of the characters, computed once when interned.
+        Util::Hash GetHash() const { return _entry ? _entry->hash : 0; }
+        /// Return copy as string.
+        String ToString() const { return String(CString(), Length()); }
+
+        /// Return hash value for hash containers.
+        size_t ToHash() const { return static_cast<size_t>(GetHash()); }
+
+        /// Return name of string if already interned, empty name otherwise. Does not add to the table.
+        static Name Find(const char* str, uint32_t length);
+        /// Return number of interned strings.
+        static size_t GetCount();
+        /// Return bytes used by the interned strings.
+        static size_t GetMemoryUsage();
+
+        /// Table entry, followed by the characters.
+        struct Entry
+        {
+            /// Next entry with the same hash.
+            Entry* next;
+            Util::Hash hash;
+            uint32_t length;
+            char data[1];
+        };
+
+    private:
+        explicit Name(const Entry* entry) : _entry(entry) {}
+
+        const Entry* _entry = nullptr;
+    };
+}
+
+namespace std {
+    template<>
+    class hash<Alimer::Name> {
+    public:
+        size_t operator()(const Alimer::Name& name) const
+        {
+            return name.ToHash();
+        }
+    };
+}
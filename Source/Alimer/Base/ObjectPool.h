@@ -22,9 +22,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
+#include <stdint.h>
 #include <stdlib.h>
 
 namespace Util
@@ -108,4 +113,383 @@ namespace Util
     private:
         std::mutex lock;
     };
+
+    // Object pool usable from many threads without taking a lock on the fast path.
+    // Every thread allocates from and frees to its own pair of magazines (fixed size stacks of vacant objects)
+    // and trades full and empty magazines with lock-free global lists in batches, so the shared state is
+    // touched once per magazine_size operations. Only growth takes a lock. trim() returns blocks without
+    // live objects to the system.
+    template<typename T>
+    class ConcurrentObjectPool
+    {
+    public:
+        ConcurrentObjectPool()
+            : id(next_id())
+        {
+            for (auto &slab : slabs)
+                slab.store(nullptr, std::memory_order_relaxed);
+        }
+
+        ~ConcurrentObjectPool()
+        {
+            for (auto &block : blocks)
+                ::free(block.memory);
+
+            ThreadCache *cache = caches.load(std::memory_order_acquire);
+            while (cache)
+            {
+                ThreadCache *next = cache->next;
+                delete cache;
+                cache = next;
+            }
+
+            for (auto &slab : slabs)
+                delete[] slab.load(std::memory_order_relaxed);
+        }
+
+        template<typename... P>
+        T *allocate(P &&... p)
+        {
+            ThreadCache &cache = get_cache();
+            if (cache.loaded->count == 0)
+            {
+                if (cache.previous->count != 0)
+                {
+                    std::swap(cache.loaded, cache.previous);
+                    std::swap(cache.loaded_index, cache.previous_index);
+                }
+                else
+                {
+                    uint32_t index = pop(full_head);
+                    if (index == invalid_index)
+                    {
+                        index = grow();
+                        if (index == invalid_index)
+                            return nullptr;
+                    }
+
+                    // Both magazines are empty: hand one back and keep the other for frees.
+                    push(empty_head, cache.previous_index);
+                    cache.previous = cache.loaded;
+                    cache.previous_index = cache.loaded_index;
+                    cache.loaded = &get_magazine(index);
+                    cache.loaded_index = index;
+                }
+            }
+
+            T *ptr = cache.loaded->objects[--cache.loaded->count];
+            new(ptr) T(std::forward<P>(p)...);
+            return ptr;
+        }
+
+        void free(T *ptr)
+        {
+            ptr->~T();
+
+            ThreadCache &cache = get_cache();
+            if (cache.loaded->count == magazine_size)
+            {
+                if (cache.previous->count != magazine_size)
+                {
+                    std::swap(cache.loaded, cache.previous);
+                    std::swap(cache.loaded_index, cache.previous_index);
+                }
+                else
+                {
+                    // Both magazines are full: publish one and continue with an empty one.
+                    push(full_head, cache.previous_index);
+                    cache.previous = cache.loaded;
+                    cache.previous_index = cache.loaded_index;
+                    cache.loaded_index = pop_empty();
+                    cache.loaded = &get_magazine(cache.loaded_index);
+                }
+            }
+
+            cache.loaded->objects[cache.loaded->count++] = ptr;
+        }
+
+        // Release blocks without live objects. Must not run concurrently with allocate or free.
+        void trim()
+        {
+            std::vector<T *> vacant;
+            std::vector<uint32_t> magazines;
+            collect(vacant, magazines);
+            std::sort(vacant.begin(), vacant.end());
+
+            // Vacant objects are sorted, so the ones of each block are contiguous.
+            std::vector<Block> kept;
+            std::vector<T *> remaining;
+            remaining.reserve(vacant.size());
+            std::sort(blocks.begin(), blocks.end(), [](const Block &a, const Block &b) { return a.memory < b.memory; });
+            auto it = vacant.begin();
+            for (auto &block : blocks)
+            {
+                auto begin = std::lower_bound(it, vacant.end(), block.memory);
+                auto end = std::lower_bound(begin, vacant.end(), block.memory + block.count);
+                if (size_t(end - begin) == block.count)
+                {
+                    ::free(block.memory);
+                }
+                else
+                {
+                    remaining.insert(remaining.end(), begin, end);
+                    kept.push_back(block);
+                }
+                it = end;
+            }
+            blocks.swap(kept);
+
+            refill(remaining, magazines);
+        }
+
+        // Drop all memory. Objects must not be used afterwards. Must not run concurrently with allocate or free.
+        void clear()
+        {
+            std::vector<T *> vacant;
+            std::vector<uint32_t> magazines;
+            collect(vacant, magazines);
+
+            for (auto &block : blocks)
+                ::free(block.memory);
+            blocks.clear();
+
+            refill(std::vector<T *>(), magazines);
+        }
+
+    private:
+        static constexpr uint32_t magazine_size = 64;
+        static constexpr uint32_t slab_size = 64;
+        static constexpr uint32_t max_slabs = 1024;
+        static constexpr uint32_t max_block_objects = 4096;
+        static constexpr uint32_t max_block_shift = 6;
+        static_assert((magazine_size << max_block_shift) == max_block_objects, "Block growth must end at max_block_objects");
+        static constexpr uint32_t cache_slots = 4;
+        static constexpr uint32_t invalid_index = 0xffffffffu;
+
+        struct Magazine
+        {
+            uint32_t count = 0;
+            std::atomic<uint32_t> next{ invalid_index };
+            T *objects[magazine_size];
+        };
+
+        struct ThreadCache
+        {
+            Magazine *loaded;
+            Magazine *previous;
+            uint32_t loaded_index;
+            uint32_t previous_index;
+            std::thread::id owner;
+            ThreadCache *next;
+        };
+
+        struct Block
+        {
+            T *memory;
+            size_t count;
+        };
+
+        static uint64_t next_id()
+        {
+            static std::atomic<uint64_t> ids{ 1 };
+            return ids.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        ThreadCache &get_cache()
+        {
+            struct CacheSlot
+            {
+                uint64_t pool;
+                ThreadCache *cache;
+            };
+            static thread_local CacheSlot slots[cache_slots] = {};
+
+            CacheSlot &slot = slots[id % cache_slots];
+            if (slot.pool == id)
+                return *slot.cache;
+
+            // The slot may have been taken by another pool, reuse the cache this thread registered before.
+            // Caches are only ever prepended, so the list can be walked while other threads register.
+            const std::thread::id owner = std::this_thread::get_id();
+            ThreadCache *cache = caches.load(std::memory_order_acquire);
+            while (cache && cache->owner != owner)
+                cache = cache->next;
+
+            if (!cache)
+            {
+                cache = new ThreadCache();
+                cache->loaded_index = pop_empty();
+                cache->loaded = &get_magazine(cache->loaded_index);
+                cache->previous_index = pop_empty();
+                cache->previous = &get_magazine(cache->previous_index);
+                cache->owner = owner;
+                cache->next = caches.load(std::memory_order_relaxed);
+                while (!caches.compare_exchange_weak(cache->next, cache, std::memory_order_release, std::memory_order_relaxed))
+                {
+                }
+            }
+
+            slot.pool = id;
+            slot.cache = cache;
+            return *cache;
+        }
+
+        Magazine &get_magazine(uint32_t index)
+        {
+            return slabs[index / slab_size].load(std::memory_order_acquire)[index % slab_size];
+        }
+
+        // Return an empty magazine from the global list, or a new one.
+        uint32_t pop_empty()
+        {
+            uint32_t index = pop(empty_head);
+            if (index != invalid_index)
+                return index;
+
+            index = magazine_count.fetch_add(1, std::memory_order_relaxed);
+            assert(index / slab_size < max_slabs);
+            auto &slab = slabs[index / slab_size];
+            if (!slab.load(std::memory_order_acquire))
+            {
+                Magazine *expected = nullptr;
+                Magazine *created = new Magazine[slab_size];
+                if (!slab.compare_exchange_strong(expected, created, std::memory_order_acq_rel))
+                    delete[] created;
+            }
+            return index;
+        }
+
+        // Lists are (tag << 32 | index) words, the tag changes with every update to rule out ABA.
+        void push(std::atomic<uint64_t> &head, uint32_t index)
+        {
+            Magazine &magazine = get_magazine(index);
+            uint64_t old = head.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                magazine.next.store(uint32_t(old), std::memory_order_relaxed);
+                const uint64_t desired = (((old >> 32) + 1) << 32) | index;
+                if (head.compare_exchange_weak(old, desired, std::memory_order_release, std::memory_order_relaxed))
+                    return;
+            }
+        }
+
+        uint32_t pop(std::atomic<uint64_t> &head)
+        {
+            uint64_t old = head.load(std::memory_order_acquire);
+            for (;;)
+            {
+                const uint32_t index = uint32_t(old);
+                if (index == invalid_index)
+                    return invalid_index;
+
+                const uint32_t next = get_magazine(index).next.load(std::memory_order_relaxed);
+                const uint64_t desired = (((old >> 32) + 1) << 32) | next;
+                if (head.compare_exchange_weak(old, desired, std::memory_order_acquire, std::memory_order_acquire))
+                    return index;
+            }
+        }
+
+        // Allocate a block, publish it as full magazines and return one of them.
+        uint32_t grow()
+        {
+            size_t count;
+            T *memory;
+            {
+                std::lock_guard<std::mutex> holder{ block_lock };
+                // Blocks double until max_block_objects, clamp before shifting so the shift can not overflow.
+                count = blocks.size() >= max_block_shift ? max_block_objects : size_t(magazine_size) << blocks.size();
+                memory = static_cast<T *>(malloc(count * sizeof(T)));
+                if (!memory)
+                    return invalid_index;
+
+                blocks.push_back({ memory, count });
+            }
+
+            uint32_t result = invalid_index;
+            for (size_t i = 0; i < count; i += magazine_size)
+            {
+                const uint32_t index = pop_empty();
+                Magazine &magazine = get_magazine(index);
+                for (uint32_t j = 0; j < magazine_size; j++)
+                    magazine.objects[j] = &memory[i + j];
+                magazine.count = magazine_size;
+
+                if (result == invalid_index)
+                    result = index;
+                else
+                    push(full_head, index);
+            }
+            return result;
+        }
+
+        // Take every vacant object and every magazine out of the caches and global lists.
+        void collect(std::vector<T *> &vacant, std::vector<uint32_t> &magazines)
+        {
+            for (ThreadCache *cache = caches.load(std::memory_order_acquire); cache; cache = cache->next)
+            {
+                for (Magazine *magazine : { cache->loaded, cache->previous })
+                {
+                    vacant.insert(vacant.end(), magazine->objects, magazine->objects + magazine->count);
+                    magazine->count = 0;
+                }
+            }
+
+            for (uint32_t index = pop(full_head); index != invalid_index; index = pop(full_head))
+            {
+                Magazine &magazine = get_magazine(index);
+                vacant.insert(vacant.end(), magazine.objects, magazine.objects + magazine.count);
+                magazine.count = 0;
+                magazines.push_back(index);
+            }
+
+            for (uint32_t index = pop(empty_head); index != invalid_index; index = pop(empty_head))
+                magazines.push_back(index);
+        }
+
+        // Repack vacant objects into magazines. Thread caches keep their (now empty) magazines,
+        // a partial remainder goes to the first cache.
+        void refill(const std::vector<T *> &vacant, std::vector<uint32_t> &magazines)
+        {
+            size_t i = 0;
+            while (vacant.size() - i >= magazine_size)
+            {
+                uint32_t index;
+                if (!magazines.empty())
+                {
+                    index = magazines.back();
+                    magazines.pop_back();
+                }
+                else
+                {
+                    index = pop_empty();
+                }
+
+                Magazine &magazine = get_magazine(index);
+                std::copy(vacant.begin() + i, vacant.begin() + i + magazine_size, magazine.objects);
+                magazine.count = magazine_size;
+                push(full_head, index);
+                i += magazine_size;
+            }
+
+            for (uint32_t index : magazines)
+                push(empty_head, index);
+
+            // Vacant objects only exist once some thread registered a cache.
+            ThreadCache *cache = caches.load(std::memory_order_acquire);
+            if (i < vacant.size())
+            {
+                std::copy(vacant.begin() + i, vacant.end(), cache->loaded->objects);
+                cache->loaded->count = uint32_t(vacant.size() - i);
+            }
+        }
+
+        uint64_t id;
+        std::atomic<uint64_t> full_head{ invalid_index };
+        std::atomic<uint64_t> empty_head{ invalid_index };
+        std::atomic<uint32_t> magazine_count{ 0 };
+        std::atomic<Magazine *> slabs[max_slabs];
+        std::atomic<ThreadCache *> caches{ nullptr };
+        std::mutex block_lock;
+        std::vector<Block> blocks;
+    };
 }
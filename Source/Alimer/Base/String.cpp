@@ -26,21 +26,14 @@
 
 namespace Alimer
 {
-    char String::END_ZERO = 0;
     const String String::EMPTY;
 
     String::String(const WString& str)
-        : _length(0)
-        , _capacity(0)
-        , _buffer(&END_ZERO)
     {
         SetUTF8FromWChar(str.CString());
     }
 
     String::String(int value)
-        : _length(0)
-        , _capacity(0)
-        , _buffer(&END_ZERO)
     {
         char tempBuffer[CONVERSION_BUFFER_LENGTH];
         sprintf(tempBuffer, "%d", value);
@@ -48,9 +41,6 @@ namespace Alimer
     }
 
     String::String(short value)
-        : _length(0)
-        , _capacity(0)
-        , _buffer(&END_ZERO)
     {
         char tempBuffer[CONVERSION_BUFFER_LENGTH];
         sprintf(tempBuffer, "%d", value);
@@ -58,9 +48,6 @@ namespace Alimer
     }
 
     String::String(long value)
-        : _length(0)
-        , _capacity(0)
-        , _buffer(&END_ZERO)
     {
         char tempBuffer[CONVERSION_BUFFER_LENGTH];
         sprintf(tempBuffer, "%ld", value);
@@ -68,9 +55,6 @@ namespace Alimer
     }
 
     String::String(long long value)
-        : _length(0)
-        , _capacity(0)
-        , _buffer(&END_ZERO)
     {
         char tempBuffer[CONVERSION_BUFFER_LENGTH];
         sprintf(tempBuffer, "%lld", value);
@@ -78,9 +62,6 @@ namespace Alimer
     }
 
     String::String(unsigned value)
-        : _length(0)
-        , _capacity(0)
-        , _buffer(&END_ZERO)
     {
         char tempBuffer[CONVERSION_BUFFER_LENGTH];
         sprintf(tempBuffer, "%u", value);
@@ -88,9 +69,6 @@ namespace Alimer
     }
 
     String::String(unsigned short value)
-        : _length(0)
-        , _capacity(0)
-        , _buffer(&END_ZERO)
     {
         char tempBuffer[CONVERSION_BUFFER_LENGTH];
         sprintf(tempBuffer, "%u", value);
@@ -98,9 +76,6 @@ namespace Alimer
     }
 
     String::String(unsigned long value)
-        : _length(0)
-        , _capacity(0)
-        , _buffer(&END_ZERO)
     {
         char tempBuffer[CONVERSION_BUFFER_LENGTH];
         sprintf(tempBuffer, "%lu", value);
@@ -108,9 +83,6 @@ namespace Alimer
     }
 
     String::String(unsigned long long value)
-        : _length(0)
-        , _capacity(0)
-        , _buffer(&END_ZERO)
     {
         char tempBuffer[CONVERSION_BUFFER_LENGTH];
         sprintf(tempBuffer, "%llu", value);
@@ -118,9 +90,6 @@ namespace Alimer
     }
 
     String::String(float value)
-        : _length(0)
-        , _capacity(0)
-        , _buffer(&END_ZERO)
     {
         char tempBuffer[CONVERSION_BUFFER_LENGTH];
         sprintf(tempBuffer, "%g", value);
@@ -128,9 +97,6 @@ namespace Alimer
     }
 
     String::String(double value)
-        : _length(0)
-        , _capacity(0)
-        , _buffer(&END_ZERO)
     {
         char tempBuffer[CONVERSION_BUFFER_LENGTH];
         sprintf(tempBuffer, "%.15g", value);
@@ -138,9 +104,6 @@ namespace Alimer
     }
 
     String::String(bool value)
-        : _length(0)
-        , _capacity(0)
-        , _buffer(&END_ZERO)
     {
         if (value)
             *this = "true";
@@ -149,18 +112,12 @@ namespace Alimer
     }
 
     String::String(char value)
-        : _length(0)
-        , _capacity(0)
-        , _buffer(&END_ZERO)
     {
         Resize(1);
         _buffer[0] = value;
     }
 
     String::String(char value, uint32_t length)
-        : _length(0)
-        , _capacity(0)
-        , _buffer(&END_ZERO)
     {
         Resize(length);
         for (uint32_t i = 0; i < length; ++i)
@@ -219,39 +176,25 @@ namespace Alimer
 
     void String::Resize(uint32_t newLength)
     {
-        if (!_capacity)
+        uint32_t capacity = Capacity();
+        if (capacity < newLength + 1)
         {
-            // If zero length requested, do not allocate buffer yet
-            if (!newLength)
-                return;
-
-            // Calculate initial capacity
-            _capacity = newLength + 1;
-            if (_capacity < MIN_CAPACITY)
-                _capacity = MIN_CAPACITY;
-
-            _buffer = new char[_capacity];
-        }
-        else
-        {
-            if (newLength && _capacity < newLength + 1)
+            // Increase the capacity with half each time it is exceeded
+            while (capacity < newLength + 1)
             {
-                // Increase the capacity with half each time it is exceeded
-                while (_capacity < newLength + 1)
-                {
-                    _capacity += (_capacity + 1) >> 1u;
-                }
+                capacity += (capacity + 1) >> 1u;
+            }
 
-                auto* newBuffer = new char[_capacity];
-                // Move the existing data to the new buffer, then delete the old buffer
-                if (_length)
-                {
-                    CopyChars(newBuffer, _buffer, _length);
-                }
+            auto* newBuffer = new char[capacity];
+            // Move the existing data to the new buffer, then delete the old buffer
+            CopyChars(newBuffer, _buffer, _length);
+            if (!IsInline())
+            {
                 delete[] _buffer;
-
-                _buffer = newBuffer;
             }
+
+            _buffer = newBuffer;
+            _heapCapacity = capacity;
         }
 
         _buffer[newLength] = 0;
@@ -262,24 +205,37 @@ namespace Alimer
     {
         if (newCapacity < _length + 1)
             newCapacity = _length + 1;
-        if (newCapacity == _capacity)
+        if (newCapacity == Capacity())
             return;
 
+        if (newCapacity <= INLINE_CAPACITY)
+        {
+            // Move back to inline storage
+            if (!IsInline())
+            {
+                char* heapBuffer = _buffer;
+                CopyChars(_inline, heapBuffer, _length + 1);
+                _buffer = _inline;
+                delete[] heapBuffer;
+            }
+            return;
+        }
+
         auto* newBuffer = new char[newCapacity];
         // Move the existing data to the new buffer, then delete the old buffer
         CopyChars(newBuffer, _buffer, _length + 1);
-        if (_capacity)
+        if (!IsInline())
         {
             delete[] _buffer;
         }
 
-        _capacity = newCapacity;
+        _heapCapacity = newCapacity;
         _buffer = newBuffer;
     }
 
     void String::Compact()
     {
-        if (_capacity)
+        if (!IsInline())
         {
             Reserve(_length + 1);
         }
@@ -292,9 +248,21 @@ namespace Alimer
 
     void String::Swap(String& str)
     {
+        const bool inline_ = IsInline();
+        const bool otherInline = str.IsInline();
+
+        // Exchanging the inline storage also exchanges the heap capacities
+        char temp[INLINE_CAPACITY];
+        memcpy(temp, _inline, INLINE_CAPACITY);
+        memcpy(_inline, str._inline, INLINE_CAPACITY);
+        memcpy(str._inline, temp, INLINE_CAPACITY);
+
         Alimer::Swap(_length, str._length);
-        Alimer::Swap(_capacity, str._capacity);
         Alimer::Swap(_buffer, str._buffer);
+        if (otherInline)
+            _buffer = _inline;
+        if (inline_)
+            str._buffer = str._inline;
     }
 
     int String::Compare(const String& str, bool caseSensitive) const
@@ -431,9 +399,11 @@ namespace Alimer
     {
         if (str)
         {
+            // A piece of this string is found again by offset after resizing, it lies before the appended range.
+            const uint32_t offset = IsInBuffer(str) ? static_cast<uint32_t>(str - _buffer) : NPOS;
             uint32_t oldLength = _length;
             Resize(oldLength + length);
-            CopyChars(&_buffer[oldLength], str, length);
+            CopyChars(&_buffer[oldLength], offset != NPOS ? _buffer + offset : str, length);
         }
 
         return *this;
@@ -612,9 +582,27 @@ namespace Alimer
             return NPOS;
 
         char first = str._buffer[0];
-        if (!caseSensitive)
-            first = (char)tolower(first);
+        if (caseSensitive)
+        {
+            if (startPos > _length - str._length)
+                return NPOS;
 
+            // Scan for the first character with memchr, then compare the rest with memcmp
+            const char* last = _buffer + _length - str._length;
+            for (const char* ptr = _buffer + startPos; ptr <= last; ++ptr)
+            {
+                ptr = static_cast<const char*>(memchr(ptr, first, last - ptr + 1));
+                if (!ptr)
+                    break;
+
+                if (memcmp(ptr + 1, str._buffer + 1, str._length - 1) == 0)
+                    return static_cast<uint32_t>(ptr - _buffer);
+            }
+
+            return NPOS;
+        }
+
+        first = (char)tolower(first);
         for (uint32_t i = startPos; i <= _length - str._length; ++i)
         {
             char c = _buffer[i];
@@ -658,11 +646,11 @@ namespace Alimer
     {
         if (caseSensitive)
         {
-            for (uint32_t i = startPos; i < _length; ++i)
-            {
-                if (_buffer[i] == c)
-                    return i;
-            }
+            if (startPos >= _length)
+                return NPOS;
+
+            const void* ptr = memchr(_buffer + startPos, c, _length - startPos);
+            return ptr ? static_cast<uint32_t>(static_cast<const char*>(ptr) - _buffer) : NPOS;
         }
         else
         {
@@ -750,11 +738,23 @@ namespace Alimer
 
     bool String::StartsWith(const String& str, bool caseSensitive) const
     {
+        if (!str._length || str._length > _length)
+            return false;
+
+        if (caseSensitive)
+            return memcmp(_buffer, str._buffer, str._length) == 0;
+
         return Find(str, 0, caseSensitive) == 0;
     }
 
     bool String::EndsWith(const String& str, bool caseSensitive) const
     {
+        if (!str._length || str._length > _length)
+            return false;
+
+        if (caseSensitive)
+            return memcmp(_buffer + _length - str._length, str._buffer, str._length) == 0;
+
         uint32_t pos = FindLast(str, Length() - 1, caseSensitive);
         return pos != NPOS && pos == Length() - str.Length();
     }
@@ -824,6 +824,14 @@ namespace Alimer
 
     void String::Replace(uint32_t pos, uint32_t length, const char* srcStart, uint32_t srcLength)
     {
+        // Moving the tail or growing would overwrite or free a source inside this string.
+        if (IsInBuffer(srcStart))
+        {
+            const String copy(srcStart, srcLength);
+            Replace(pos, length, copy._buffer, srcLength);
+            return;
+        }
+
         int delta = (int)srcLength - (int)length;
 
         if (pos + length < _length)
@@ -50,53 +50,35 @@ namespace Alimer
 
         /// Construct empty.
         String() noexcept
-            : _length(0)
-            , _capacity(0)
-            , _buffer(&END_ZERO)
         {
         }
 
         /// Construct from another string.
         String(const String& str)
-            : _length(0)
-            , _capacity(0)
-            , _buffer(&END_ZERO)
         {
             *this = str;
         }
 
         /// Move-construct from another string.
         String(String && str) noexcept
-            : _length(0)
-            , _capacity(0)
-            , _buffer(&END_ZERO)
         {
             Swap(str);
         }
 
         /// Construct from a C string.
         String(const char* str)   // NOLINT(google-explicit-constructor)
-            : _length(0)
-            , _capacity(0)
-            , _buffer(&END_ZERO)
         {
             *this = str;
         }
 
         /// Construct from a C string.
         String(char* str) // NOLINT(google-explicit-constructor)
-            : _length(0)
-            , _capacity(0)
-            , _buffer(&END_ZERO)
         {
             *this = (const char*)str;
         }
 
         /// Construct from a char array and length.
         String(const char* str, uint32_t length)
-            : _length(0)
-            , _capacity(0)
-            , _buffer(&END_ZERO)
         {
             Resize(length);
             CopyChars(_buffer, str, length);
@@ -104,18 +86,12 @@ namespace Alimer
 
         /// Construct from a null-terminated wide character array.
         explicit String(const wchar_t* str)
-            : _length(0)
-            , _capacity(0)
-            , _buffer(&END_ZERO)
         {
             SetUTF8FromWChar(str);
         }
 
         /// Construct from a null-terminated wide character array.
         explicit String(wchar_t* str)
-            : _length(0)
-            , _capacity(0)
-            , _buffer(&END_ZERO)
         {
             SetUTF8FromWChar(str);
         }
@@ -152,27 +128,18 @@ namespace Alimer
 
         /// Construct from std::string.
         String(const std::string& str)
-            : _length(0)
-            , _capacity(0)
-            , _buffer(&END_ZERO)
         {
             *this = str.c_str();
         }
 
         /// Construct from std::wstring.
         String(const std::wstring& str)
-            : _length(0)
-            , _capacity(0)
-            , _buffer(&END_ZERO)
         {
             SetUTF8FromWChar(str.c_str());
         }
 
         /// Construct from a convertible value.
         template <class T> explicit String(const T& value)
-            : _length(0)
-            , _capacity(0)
-            , _buffer(&END_ZERO)
         {
             *this = value.ToString();
         }
@@ -180,7 +147,7 @@ namespace Alimer
         /// Destruct.
         ~String()
         {
-            if (_capacity)
+            if (!IsInline())
                 delete[] _buffer;
         }
 
@@ -208,6 +175,14 @@ namespace Alimer
         String& operator =(const char* rhs)
         {
             uint32_t rhsLength = CStringLength(rhs);
+            if (IsInBuffer(rhs))
+            {
+                // Tail of this string, shrinks in place.
+                MoveRange(0, static_cast<uint32_t>(rhs - _buffer), rhsLength);
+                Resize(rhsLength);
+                return *this;
+            }
+
             Resize(rhsLength);
             CopyChars(_buffer, rhs, rhsLength);
 
@@ -227,9 +202,11 @@ namespace Alimer
         /// Add-assign a string.
         String& operator +=(const String& rhs)
         {
+            // Read rhs before resizing, it may be this string.
+            uint32_t rhsLength = rhs._length;
             uint32_t oldLength = _length;
-            Resize(_length + rhs._length);
-            CopyChars(_buffer + oldLength, rhs._buffer, rhs._length);
+            Resize(_length + rhsLength);
+            CopyChars(_buffer + oldLength, rhs._buffer, rhsLength);
 
             return *this;
         }
@@ -237,12 +214,7 @@ namespace Alimer
         /// Add-assign a C string.
         String& operator +=(const char* rhs)
         {
-            uint32_t rhsLength = CStringLength(rhs);
-            uint32_t oldLength = _length;
-            Resize(_length + rhsLength);
-            CopyChars(_buffer + oldLength, rhs, rhsLength);
-
-            return *this;
+            return Append(rhs, CStringLength(rhs));
         }
 
         /// Add-assign a character.
@@ -313,10 +285,10 @@ namespace Alimer
         }
 
         /// Test for equality with another string.
-        bool operator ==(const String& rhs) const { return strcmp(CString(), rhs.CString()) == 0; }
+        bool operator ==(const String& rhs) const { return _length == rhs._length && memcmp(_buffer, rhs._buffer, _length) == 0; }
 
         /// Test for inequality with another string.
-        bool operator !=(const String& rhs) const { return strcmp(CString(), rhs.CString()) != 0; }
+        bool operator !=(const String& rhs) const { return !(*this == rhs); }
 
         /// Test if string is less than another string.
         bool operator <(const String& rhs) const { return strcmp(CString(), rhs.CString()) < 0; }
@@ -511,7 +483,7 @@ namespace Alimer
         uint32_t Length() const { return _length; }
 
         /// Return buffer capacity.
-        uint32_t Capacity() const { return _capacity; }
+        uint32_t Capacity() const { return IsInline() ? INLINE_CAPACITY : _heapCapacity; }
 
         /// Return whether the string is empty.
         bool IsEmpty() const { return _length == 0; }
@@ -547,12 +519,17 @@ namespace Alimer
 
         /// Position for "not found."
         static constexpr uint32_t NPOS = 0xffffffff;
-        /// Initial dynamic allocation size.
-        static constexpr uint32_t MIN_CAPACITY = 8;
+        /// Buffer size of strings stored without allocation, including the end zero.
+        static constexpr uint32_t INLINE_CAPACITY = 20;
         /// Empty string.
         static const String EMPTY;
 
     private:
+        /// Return whether the characters are stored inline.
+        bool IsInline() const { return _buffer == _inline; }
+        /// Return whether the pointer refers to the characters of this string, which resizing may move or overwrite.
+        bool IsInBuffer(const char* ptr) const { return ptr >= _buffer && ptr <= _buffer + _length; }
+
         /// Move a range of characters within the string.
         void MoveRange(uint32_t dest, uint32_t src, size_t count)
         {
@@ -565,33 +542,26 @@ namespace Alimer
         /// Copy chars from one buffer to another.
         static void CopyChars(char* dest, const char* src, size_t count)
         {
-#ifdef _MSC_VER
-            if (count) {
-                memcpy(dest, src, count);
-            }
-#else
-            char* end = dest + count;
-            while (dest != end)
+            if (count)
             {
-                *dest = *src;
-                ++dest;
-                ++src;
+                memcpy(dest, src, count);
             }
-#endif
         }
 
         /// Replace a substring with another substring.
         void Replace(uint32_t pos, uint32_t length, const char* srcStart, uint32_t srcLength);
 
+        /// String buffer, points to _inline for short strings.
+        char* _buffer = _inline;
         /// String length.
-        uint32_t _length;
-        /// Capacity, zero if buffer not allocated.
-        uint32_t _capacity;
-        /// String buffer, point to &endZero if buffer is not allocated.
-        char* _buffer;
-
-        /// End zero for empty strings.
-        static char END_ZERO;
+        uint32_t _length = 0;
+        union
+        {
+            /// Capacity of the heap buffer.
+            uint32_t _heapCapacity;
+            /// Characters of short strings.
+            char _inline[INLINE_CAPACITY] = {};
+        };
     };
 
     /// Add a string to a C string.
@@ -23,6 +23,7 @@
 
 #include "../Base/StringHash.h"
 #include "../Base/String.h"
+#include "../Base/HashMap.h"
 
 namespace Alimer
 {
@@ -45,14 +46,8 @@ namespace Alimer
         if (!data)
             return hash;
 
-        auto* bytes = static_cast<uint8_t*>(data);
-        auto* end = bytes + length;
-        while (bytes < end)
-        {
-            hash = SDBMHash(hash, *bytes);
-            ++bytes;
-        }
-
-        return hash;
+        // Binary data takes the bulk 64 bit path, folded to 32 bits.
+        const Util::Hash result = Util::hash_bytes(data, length, hash);
+        return static_cast<uint32_t>(result ^ (result >> 32));
     }
 }
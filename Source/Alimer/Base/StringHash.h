@@ -33,16 +33,16 @@ namespace Alimer
 	{
 	public:
 		/// Construct with zero value.
-		StringHash() noexcept : _value(0) {}
+		constexpr StringHash() noexcept : _value(0) {}
 
 		/// Copy-construct.
-		StringHash(const StringHash& rhs) noexcept = default;
+		constexpr StringHash(const StringHash& rhs) noexcept = default;
 
 		/// Construct with an initial value.
-		explicit StringHash(uint32_t value) noexcept : _value(value) { }
+		constexpr explicit StringHash(uint32_t value) noexcept : _value(value) { }
 
-		/// Construct from a C string case-insensitively.
-		StringHash(const char* str) noexcept // NOLINT(google-explicit-constructor)
+		/// Construct from a C string case-insensitively. Evaluated at compile time for literals in constant expressions.
+		constexpr StringHash(const char* str) noexcept // NOLINT(google-explicit-constructor)
             : _value(Calculate(str))
         {
         }
@@ -51,11 +51,9 @@ namespace Alimer
 		StringHash(const String& str) noexcept;      // NOLINT(google-explicit-constructor)
 
         /// Add a hash.
-        StringHash operator +(const StringHash& rhs) const
+        constexpr StringHash operator +(const StringHash& rhs) const
         {
-            StringHash ret;
-            ret._value = _value + rhs._value;
-            return ret;
+            return StringHash(_value + rhs._value);
         }
 
         /// Add-assign a hash.
@@ -66,22 +64,22 @@ namespace Alimer
         }
 
 		/// Test for equality with another hash.
-		bool operator == (const StringHash& rhs) const { return _value == rhs._value; }
+		constexpr bool operator == (const StringHash& rhs) const { return _value == rhs._value; }
 		/// Test for inequality with another hash.
-		bool operator != (const StringHash& rhs) const { return _value != rhs._value; }
+		constexpr bool operator != (const StringHash& rhs) const { return _value != rhs._value; }
 		/// Test if less than another hash.
-		bool operator < (const StringHash& rhs) const { return _value < rhs._value; }
+		constexpr bool operator < (const StringHash& rhs) const { return _value < rhs._value; }
 		/// Test if greater than another hash.
-		bool operator > (const StringHash& rhs) const { return _value > rhs._value; }
+		constexpr bool operator > (const StringHash& rhs) const { return _value > rhs._value; }
 		/// Return true if nonzero hash value.
-		operator bool() const { return _value != 0; }
+		constexpr operator bool() const { return _value != 0; }
 		/// Return hash value.
-		uint32_t Value() const { return _value; }
+		constexpr uint32_t Value() const { return _value; }
 		/// Return as string.
 		String ToString() const;
 
 		/// Return hash value for HashSet & HashMap.
-		uint32_t ToHash() const { return _value; }
+		constexpr uint32_t ToHash() const { return _value; }
 
         /// Calculate hash value case-insensitively from a C string.
         static constexpr uint32_t Calculate(const char* str, uint32_t hash = 0)
@@ -0,0 +1,185 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Base/String.h"
+
+namespace Alimer
+{
+    /// Non-owning view of a character range. Not necessarily zero terminated, the viewed characters must outlive it.
+    class StringView
+    {
+    public:
+        /// Construct empty.
+        constexpr StringView() noexcept
+            : _data("")
+            , _length(0)
+        {
+        }
+
+        /// Construct from a character range.
+        constexpr StringView(const char* data, uint32_t length) noexcept
+            : _data(data)
+            , _length(length)
+        {
+        }
+
+        /// Construct from a C string.
+        StringView(const char* str) noexcept // NOLINT(google-explicit-constructor)
+            : _data(str ? str : "")
+            , _length(String::CStringLength(str))
+        {
+        }
+
+        /// Construct from a string.
+        StringView(const String& str) noexcept // NOLINT(google-explicit-constructor)
+            : _data(str.CString())
+            , _length(str.Length())
+        {
+        }
+
+        /// Return char at index.
+        char operator [](uint32_t index) const
+        {
+            assert(index < _length);
+            return _data[index];
+        }
+
+        /// Test for equality with another view.
+        bool operator ==(const StringView& rhs) const { return _length == rhs._length && memcmp(_data, rhs._data, _length) == 0; }
+        /// Test for inequality with another view.
+        bool operator !=(const StringView& rhs) const { return !(*this == rhs); }
+
+        /// Return pointer to the first character.
+        const char* Data() const { return _data; }
+        /// Return length.
+        uint32_t Length() const { return _length; }
+        /// Return whether the view is empty.
+        bool IsEmpty() const { return _length == 0; }
+        /// Return first char, or 0 if empty.
+        char Front() const { return _length ? _data[0] : 0; }
+        /// Return last char, or 0 if empty.
+        char Back() const { return _length ? _data[_length - 1] : 0; }
+
+        /// Return a view of the characters from pos to the end.
+        StringView Substring(uint32_t pos) const
+        {
+            return pos < _length ? StringView(_data + pos, _length - pos) : StringView(_data + _length, 0);
+        }
+
+        /// Return a view of at most length characters from pos.
+        StringView Substring(uint32_t pos, uint32_t length) const
+        {
+            const StringView tail = Substring(pos);
+            return StringView(tail._data, length < tail._length ? length : tail._length);
+        }
+
+        /// Return a view without whitespace at either end.
+        StringView Trimmed() const
+        {
+            uint32_t start = 0;
+            uint32_t end = _length;
+            while (start < end && IsSpace(_data[start]))
+                ++start;
+            while (end > start && IsSpace(_data[end - 1]))
+                --end;
+
+            return StringView(_data + start, end - start);
+        }
+
+        /// Return index of the first occurrence of a character, or NPOS if not found.
+        uint32_t Find(char c, uint32_t startPos = 0) const
+        {
+            if (startPos >= _length)
+                return String::NPOS;
+
+            const void* ptr = memchr(_data + startPos, c, _length - startPos);
+            return ptr ? static_cast<uint32_t>(static_cast<const char*>(ptr) - _data) : String::NPOS;
+        }
+
+        /// Return index of the last occurrence of a character, or NPOS if not found.
+        uint32_t FindLast(char c) const
+        {
+            for (uint32_t i = _length; i > 0; --i)
+            {
+                if (_data[i - 1] == c)
+                    return i - 1;
+            }
+
+            return String::NPOS;
+        }
+
+        /// Return index of the last occurrence of any of two characters, or NPOS if not found.
+        uint32_t FindLast(char c, char d) const
+        {
+            for (uint32_t i = _length; i > 0; --i)
+            {
+                if (_data[i - 1] == c || _data[i - 1] == d)
+                    return i - 1;
+            }
+
+            return String::NPOS;
+        }
+
+        /// Return whether starts with a prefix. An empty prefix always matches.
+        bool StartsWith(const StringView& str, bool caseSensitive = true) const
+        {
+            return str._length <= _length && Substring(0, str._length).Equals(str, caseSensitive);
+        }
+
+        /// Return whether ends with a suffix. An empty suffix always matches.
+        bool EndsWith(const StringView& str, bool caseSensitive = true) const
+        {
+            return str._length <= _length && Substring(_length - str._length).Equals(str, caseSensitive);
+        }
+
+        /// Return whether equal to another view, optionally ignoring case.
+        bool Equals(const StringView& rhs, bool caseSensitive = true) const
+        {
+            if (_length != rhs._length)
+                return false;
+
+            if (caseSensitive)
+                return memcmp(_data, rhs._data, _length) == 0;
+
+            for (uint32_t i = 0; i < _length; ++i)
+            {
+                if (tolower(_data[i]) != tolower(rhs._data[i]))
+                    return false;
+            }
+
+            return true;
+        }
+
+        /// Return an owning copy.
+        String ToString() const { return String(_data, _length); }
+
+    private:
+        static bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+        /// First character.
+        const char* _data;
+        /// Number of characters.
+        uint32_t _length;
+    };
+}
@@ -94,7 +94,7 @@ namespace Util
         T *request(Hash hash)
         {
             auto itr = hashmap.find(hash);
-            if (itr != end(hashmap))
+            if (itr != hashmap.end())
             {
                 auto node = itr->second;
                 if (node->get_index() != index)
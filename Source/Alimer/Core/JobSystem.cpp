@@ -0,0 +1,245 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Core/JobSystem.h"
+#include "../Core/Platform.h"
+#include "../Core/Log.h"
+using namespace std;
+
+namespace Alimer
+{
+    static thread_local uint32_t s_threadIndex = ~0u;
+
+    JobSystem::JobSystem(uint32_t numWorkers)
+    {
+        s_threadIndex = 0;
+
+#if ALIMER_THREADING
+        if (numWorkers == 0)
+        {
+            const uint32_t hardwareThreads = thread::hardware_concurrency();
+            numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+        }
+#else
+        // Without threading support every job runs on the main thread inside Wait.
+        numWorkers = 0;
+#endif
+
+        _queues.reserve(numWorkers + 1);
+        for (uint32_t i = 0; i <= numWorkers; ++i)
+        {
+            _queues.emplace_back(new WorkQueue());
+        }
+
+        _workers.reserve(numWorkers);
+        for (uint32_t i = 1; i <= numWorkers; ++i)
+        {
+            _workers.emplace_back(&JobSystem::WorkerThread, this, i);
+        }
+
+        ALIMER_LOGDEBUGF("JobSystem started with %u worker threads.", numWorkers);
+        AddSubsystem(this);
+    }
+
+    JobSystem::~JobSystem()
+    {
+        // Drain what is left so that no counter stays pending.
+        while (TryExecuteOne(0))
+        {
+        }
+
+        {
+            lock_guard<mutex> lock(_wakeMutex);
+            _shutdown = true;
+        }
+        _wakeCondition.notify_all();
+
+        for (thread& worker : _workers)
+        {
+            worker.join();
+        }
+
+        RemoveSubsystem(this);
+    }
+
+    uint32_t JobSystem::GetCurrentThreadIndex()
+    {
+        return s_threadIndex;
+    }
+
+    void JobSystem::Schedule(JobFunction function, JobCounter* counter)
+    {
+        if (counter)
+        {
+            counter->_value.fetch_add(1, memory_order_relaxed);
+        }
+
+        Push(Job{ move(function), counter });
+    }
+
+    void JobSystem::Schedule(JobCounter& dependency, JobFunction function, JobCounter* counter)
+    {
+        if (counter)
+        {
+            counter->_value.fetch_add(1, memory_order_relaxed);
+        }
+
+        {
+            lock_guard<mutex> lock(dependency._mutex);
+            if (!dependency.IsDone())
+            {
+                dependency._continuations.push_back({ move(function), counter });
+                return;
+            }
+        }
+
+        Push(Job{ move(function), counter });
+    }
+
+    void JobSystem::Wait(JobCounter& counter)
+    {
+        uint32_t queueIndex = s_threadIndex < _queues.size() ? s_threadIndex : 0;
+        while (!counter.IsDone())
+        {
+            if (!TryExecuteOne(queueIndex))
+            {
+                this_thread::yield();
+            }
+        }
+
+        // Synchronize with the finishing thread before the caller may release the counter.
+        lock_guard<mutex> lock(counter._mutex);
+    }
+
+    void JobSystem::WorkerThread(uint32_t index)
+    {
+        s_threadIndex = index;
+
+        char name[32];
+        snprintf(name, sizeof(name), "Worker %u", index);
+        SetCurrentThreadName(name);
+
+        while (true)
+        {
+            if (TryExecuteOne(index))
+                continue;
+
+            unique_lock<mutex> lock(_wakeMutex);
+            _wakeCondition.wait(lock, [this]() {
+                return _shutdown || _pendingJobs.load(memory_order_acquire) > 0;
+            });
+
+            if (_shutdown)
+                break;
+        }
+    }
+
+    void JobSystem::Push(Job&& job)
+    {
+        uint32_t queueIndex = s_threadIndex < _queues.size() ? s_threadIndex : 0;
+        WorkQueue& queue = *_queues[queueIndex];
+        {
+            lock_guard<mutex> lock(queue.mutex);
+            queue.jobs.push_back(move(job));
+        }
+
+        _pendingJobs.fetch_add(1, memory_order_release);
+        if (!_workers.empty())
+        {
+            // Taking the lock orders the notify after a worker's predicate check.
+            lock_guard<mutex> lock(_wakeMutex);
+            _wakeCondition.notify_one();
+        }
+    }
+
+    bool JobSystem::Pop(uint32_t queueIndex, Job& job)
+    {
+        WorkQueue& queue = *_queues[queueIndex];
+        lock_guard<mutex> lock(queue.mutex);
+        if (queue.jobs.empty())
+            return false;
+
+        job = move(queue.jobs.back());
+        queue.jobs.pop_back();
+        return true;
+    }
+
+    bool JobSystem::Steal(uint32_t thiefIndex, Job& job)
+    {
+        const uint32_t queueCount = static_cast<uint32_t>(_queues.size());
+        for (uint32_t i = 1; i < queueCount; ++i)
+        {
+            WorkQueue& queue = *_queues[(thiefIndex + i) % queueCount];
+            unique_lock<mutex> lock(queue.mutex, try_to_lock);
+            if (!lock.owns_lock() || queue.jobs.empty())
+                continue;
+
+            job = move(queue.jobs.front());
+            queue.jobs.pop_front();
+            return true;
+        }
+
+        return false;
+    }
+
+    bool JobSystem::TryExecuteOne(uint32_t queueIndex)
+    {
+        if (_pendingJobs.load(memory_order_acquire) == 0)
+            return false;
+
+        Job job;
+        if (!Pop(queueIndex, job) && !Steal(queueIndex, job))
+            return false;
+
+        _pendingJobs.fetch_sub(1, memory_order_acq_rel);
+        Execute(job);
+        return true;
+    }
+
+    void JobSystem::Execute(Job& job)
+    {
+        job.function();
+        Finish(job.counter);
+    }
+
+    void JobSystem::Finish(JobCounter* counter)
+    {
+        if (!counter)
+            return;
+
+        // Decrement under the lock so that a dependent Schedule either sees the counter pending
+        // and queues itself, or sees it done; Wait also takes the lock before returning.
+        vector<JobCounter::Continuation> continuations;
+        {
+            lock_guard<mutex> lock(counter->_mutex);
+            if (counter->_value.fetch_sub(1, memory_order_acq_rel) != 1)
+                return;
+
+            continuations.swap(counter->_continuations);
+        }
+
+        for (JobCounter::Continuation& continuation : continuations)
+        {
+            Push(Job{ move(continuation.function), continuation.counter });
+        }
+    }
+}
@@ -0,0 +1,161 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/Object.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Alimer
+{
+    class JobSystem;
+
+    /// Job work function.
+    using JobFunction = std::function<void()>;
+
+    /// Counter tracking a group of scheduled jobs. Jobs scheduled with a dependency on the counter run once it reaches zero.
+    class ALIMER_API JobCounter final
+    {
+        friend class JobSystem;
+
+    public:
+        /// Constructor.
+        JobCounter() = default;
+
+        /// Return number of jobs still pending.
+        uint32_t GetValue() const { return _value.load(std::memory_order_acquire); }
+
+        /// Return whether all jobs tracked by this counter have finished.
+        bool IsDone() const { return GetValue() == 0; }
+
+    private:
+        struct Continuation
+        {
+            JobFunction function;
+            JobCounter* counter;
+        };
+
+        /// Pending job count.
+        std::atomic<uint32_t> _value{ 0 };
+        /// Guards continuation list.
+        std::mutex _mutex;
+        /// Jobs waiting for this counter to reach zero.
+        std::vector<Continuation> _continuations;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(JobCounter);
+    };
+
+    /// Work-stealing job scheduler with one queue per worker thread.
+    class ALIMER_API JobSystem final : public Object
+    {
+        ALIMER_OBJECT(JobSystem, Object);
+
+    public:
+        /// Constructor. Zero worker count uses hardware concurrency minus the calling thread.
+        explicit JobSystem(uint32_t numWorkers = 0);
+
+        /// Destructor. Finishes outstanding jobs and joins worker threads.
+        ~JobSystem() override;
+
+        /// Schedule job, optionally incrementing counter until the job has run.
+        void Schedule(JobFunction function, JobCounter* counter = nullptr);
+
+        /// Schedule job that starts only after dependency counter reaches zero.
+        void Schedule(JobCounter& dependency, JobFunction function, JobCounter* counter = nullptr);
+
+        /// Wait for counter to reach zero, executing pending jobs on the calling thread meanwhile.
+        void Wait(JobCounter& counter);
+
+        /// Execute func(begin, end) over [0, count) split in batches of grainSize, and wait for completion.
+        template <typename Function>
+        void ParallelFor(uint32_t count, uint32_t grainSize, Function&& func)
+        {
+            if (count == 0)
+                return;
+
+            if (grainSize == 0)
+                grainSize = 1;
+
+            // Run directly when the range fits in a single batch.
+            if (count <= grainSize || _workers.empty())
+            {
+                func(0u, count);
+                return;
+            }
+
+            JobCounter counter;
+            for (uint32_t begin = grainSize; begin < count; begin += grainSize)
+            {
+                const uint32_t end = count - begin > grainSize ? begin + grainSize : count;
+                Schedule([&func, begin, end]() { func(begin, end); }, &counter);
+            }
+
+            // The calling thread processes the first batch itself.
+            func(0u, grainSize);
+            Wait(counter);
+        }
+
+        /// Return number of worker threads, excluding the main thread.
+        uint32_t GetWorkerCount() const { return static_cast<uint32_t>(_workers.size()); }
+
+        /// Return index of the calling thread: zero for the main thread, 1..N for workers, ~0 for foreign threads.
+        static uint32_t GetCurrentThreadIndex();
+
+    private:
+        struct Job
+        {
+            JobFunction function;
+            JobCounter* counter;
+        };
+
+        /// Double-ended queue owned by one thread. The owner pushes and pops at the back, thieves steal from the front.
+        struct WorkQueue
+        {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        void WorkerThread(uint32_t index);
+        void Push(Job&& job);
+        bool Pop(uint32_t queueIndex, Job& job);
+        bool Steal(uint32_t thiefIndex, Job& job);
+        bool TryExecuteOne(uint32_t queueIndex);
+        void Execute(Job& job);
+        void Finish(JobCounter* counter);
+
+        std::vector<std::thread> _workers;
+        std::vector<std::unique_ptr<WorkQueue>> _queues;
+        std::atomic<uint32_t> _pendingJobs{ 0 };
+        std::atomic<bool> _shutdown{ false };
+        std::mutex _wakeMutex;
+        std::condition_variable _wakeCondition;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(JobSystem);
+    };
+}
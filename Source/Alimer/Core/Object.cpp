@@ -62,13 +62,6 @@ namespace Alimer
         }
     }
 
-    TypeInfo::TypeInfo(const char* typeName, const TypeInfo* baseTypeInfo)
-        : _type(typeName)
-        , _typeName(typeName)
-        , _baseTypeInfo(baseTypeInfo)
-    {
-    }
-
     bool TypeInfo::IsTypeOf(StringHash type) const
     {
         const TypeInfo* current = this;
@@ -99,6 +92,9 @@ namespace Alimer
 
     bool Object::IsInstanceOf(StringHash type) const
     {
+        if (GetType() == type)
+            return true;
+
         return GetTypeInfo()->IsTypeOf(type);
     }
 
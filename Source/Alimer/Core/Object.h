@@ -26,18 +26,25 @@
 #include "../Core/Ptr.h"
 #include "../Base/StringHash.h"
 #include "../Core/Event.h"
+#include <type_traits>
 
 namespace Alimer
 {
     class ObjectFactory;
     template <class T> class ObjectFactoryImpl;
 
-    /// Type info.
+    /// Type info. Constructed from constants only, so that static instances need no initialization guard.
     class ALIMER_API TypeInfo final
     {
     public:
-        /// Constructor.
-        TypeInfo(const char* typeName, const TypeInfo* baseTypeInfo);
+        /// Constructor. The base type info is reached through its static getter.
+        constexpr TypeInfo(const char* typeName, StringHash type, const TypeInfo* (*baseTypeInfoGetter)()) noexcept
+            : _type(type)
+            , _typeName(typeName)
+            , _baseTypeInfoGetter(baseTypeInfoGetter)
+        {
+        }
+
         /// Destructor.
         ~TypeInfo() = default;
 
@@ -49,19 +56,19 @@ namespace Alimer
         template<typename T> bool IsTypeOf() const { return IsTypeOf(T::GetTypeInfoStatic()); }
 
         /// Return type.
-        StringHash GetType() const { return _type; }
+        constexpr StringHash GetType() const { return _type; }
         /// Return type name.
-        const std::string& GetTypeName() const { return _typeName; }
+        constexpr const char* GetTypeName() const { return _typeName; }
         /// Return base type info.
-        const TypeInfo* GetBaseTypeInfo() const { return _baseTypeInfo; }
+        const TypeInfo* GetBaseTypeInfo() const { return _baseTypeInfoGetter ? _baseTypeInfoGetter() : nullptr; }
 
     private:
         /// Type.
         StringHash _type;
         /// Type name.
-        std::string _typeName;
-        /// Base class type info.
-        const TypeInfo* _baseTypeInfo;
+        const char* _typeName;
+        /// Getter of base class type info.
+        const TypeInfo* (*_baseTypeInfoGetter)();
 
         DISALLOW_COPY_MOVE_AND_ASSIGN(TypeInfo);
     };
@@ -88,7 +95,7 @@ namespace Alimer
         /// Check current instance is type of specified type.
         bool IsInstanceOf(const TypeInfo* typeInfo) const;
         /// Check current instance is type of specified class.
-        template<typename T> bool IsInstanceOf() const { return IsInstanceOf(T::GetTypeInfoStatic()); }
+        template<typename T> bool IsInstanceOf() const { return IsInstanceOf(T::GetTypeStatic()); }
         /// Cast the object to specified most derived class.
         template<typename T> T* Cast() { return IsInstanceOf<T>() ? static_cast<T*>(this) : nullptr; }
         /// Cast the object to specified most derived class.
@@ -128,9 +135,9 @@ namespace Alimer
 	public: \
 		using ClassName = typeName; \
 		using Parent = baseTypeName; \
-		virtual Alimer::StringHash GetType() const override { return GetTypeInfoStatic()->GetType(); } \
-		virtual const std::string& GetTypeName() const override { return GetTypeInfoStatic()->GetTypeName(); } \
+		virtual Alimer::StringHash GetType() const override { return GetTypeStatic(); } \
+		virtual const std::string& GetTypeName() const override { return GetTypeNameStatic(); } \
 		virtual const Alimer::TypeInfo* GetTypeInfo() const override { return GetTypeInfoStatic(); } \
-		static Alimer::StringHash GetTypeStatic() { return GetTypeInfoStatic()->GetType(); } \
-		static const std::string& GetTypeNameStatic() { return GetTypeInfoStatic()->GetTypeName(); } \
-		static const Alimer::TypeInfo* GetTypeInfoStatic() { static const Alimer::TypeInfo typeInfoStatic(#typeName, Parent::GetTypeInfoStatic()); return &typeInfoStatic; }
+		static constexpr Alimer::StringHash GetTypeStatic() { return Alimer::StringHash(std::integral_constant<uint32_t, Alimer::StringHash::Calculate(#typeName)>::value); } \
+		static const std::string& GetTypeNameStatic() { static const std::string typeNameStatic(#typeName); return typeNameStatic; } \
+		static const Alimer::TypeInfo* GetTypeInfoStatic() { static const Alimer::TypeInfo typeInfoStatic(#typeName, GetTypeStatic(), &Parent::GetTypeInfoStatic); return &typeInfoStatic; }
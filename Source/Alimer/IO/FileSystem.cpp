@@ -117,74 +117,127 @@ namespace Alimer
         return ret;
     }
 
-    void SplitPath(const String& fullPath, String& pathName, String& fileName, String& extension, bool lowerCaseExtension)
+    /// Lowercase a string in place.
+    static void ToLowerInPlace(String& str)
     {
-        String fullPathCopy = GetInternalPath(fullPath);
-
-        uint32_t extPos = fullPathCopy.FindLast('.');
-        uint32_t pathPos = fullPathCopy.FindLast('/');
-
-        if (extPos != String::NPOS
-            && (pathPos == String::NPOS || extPos > pathPos))
+        for (uint32_t i = 0; i < str.Length(); ++i)
         {
-            extension = fullPathCopy.Substring(extPos);
-            if (lowerCaseExtension)
-            {
-                extension = extension.ToLower();
-            }
-
-            fullPathCopy = fullPathCopy.Substring(0, extPos);
-        }
-        else {
-            extension.Clear();
+            str[i] = (char)tolower(str[i]);
         }
+    }
+
+    /// Return copy of a path piece converted to internal format.
+    static String ToInternalPath(StringView path)
+    {
+        String ret = path.ToString();
+        ret.Replace('\\', '/');
+        return ret;
+    }
 
-        pathPos = fullPathCopy.FindLast('/');
-        if (pathPos != String::NPOS)
+    void SplitPath(StringView fullPath, StringView& pathName, StringView& fileName, StringView& extension)
+    {
+        const uint32_t pathPos = fullPath.FindLast('/', '\\');
+        const uint32_t fileStart = pathPos != String::NPOS ? pathPos + 1 : 0;
+        pathName = fullPath.Substring(0, fileStart);
+
+        StringView fileAndExtension = fullPath.Substring(fileStart);
+        const uint32_t extPos = fileAndExtension.FindLast('.');
+        if (extPos != String::NPOS)
         {
-            fileName = fullPathCopy.Substring(pathPos + 1);
-            pathName = fullPathCopy.Substring(0, pathPos + 1);
+            fileName = fileAndExtension.Substring(0, extPos);
+            extension = fileAndExtension.Substring(extPos);
         }
         else
         {
-            fileName = fullPathCopy;
-            pathName.Clear();
+            fileName = fileAndExtension;
+            extension = StringView(fileAndExtension.Data() + fileAndExtension.Length(), 0);
         }
     }
 
-    String GetPath(const String& fullPath)
+    StringView GetPathView(StringView fullPath)
     {
-        String path, file, extension;
+        StringView path, file, extension;
         SplitPath(fullPath, path, file, extension);
         return path;
     }
 
-    String GetFileName(const String& fullPath)
+    StringView GetFileNameView(StringView fullPath)
     {
-        String path, file, extension;
+        StringView path, file, extension;
         SplitPath(fullPath, path, file, extension);
         return file;
     }
 
+    StringView GetExtensionView(StringView fullPath)
+    {
+        StringView path, file, extension;
+        SplitPath(fullPath, path, file, extension);
+        return extension;
+    }
+
+    StringView GetFileNameAndExtensionView(StringView fullPath)
+    {
+        const uint32_t pathPos = fullPath.FindLast('/', '\\');
+        return pathPos != String::NPOS ? fullPath.Substring(pathPos + 1) : fullPath;
+    }
+
+    void SplitPath(const String& fullPath, String& pathName, String& fileName, String& extension, bool lowerCaseExtension)
+    {
+        StringView pathView, fileView, extensionView;
+        SplitPath(fullPath, pathView, fileView, extensionView);
+
+        pathName = ToInternalPath(pathView);
+        fileName = fileView.ToString();
+        extension = extensionView.ToString();
+        if (lowerCaseExtension)
+        {
+            ToLowerInPlace(extension);
+        }
+    }
+
+    String GetPath(const String& fullPath)
+    {
+        return ToInternalPath(GetPathView(fullPath));
+    }
+
+    String GetFileName(const String& fullPath)
+    {
+        return GetFileNameView(fullPath).ToString();
+    }
+
     String GetExtension(const String& fullPath, bool lowercaseExtension)
     {
-        String path, file, extension;
-        SplitPath(fullPath, path, file, extension, lowercaseExtension);
+        String extension = GetExtensionView(fullPath).ToString();
+        if (lowercaseExtension)
+        {
+            ToLowerInPlace(extension);
+        }
         return extension;
     }
 
     String GetFileNameAndExtension(const String& fileName, bool lowercaseExtension)
     {
-        String path, file, extension;
-        SplitPath(fileName, path, file, extension, lowercaseExtension);
-        return file + extension;
+        String ret = GetFileNameAndExtensionView(fileName).ToString();
+        if (lowercaseExtension)
+        {
+            const uint32_t extPos = ret.FindLast('.');
+            for (uint32_t i = extPos; i < ret.Length(); ++i)
+            {
+                ret[i] = (char)tolower(ret[i]);
+            }
+        }
+        return ret;
     }
 
     String GetParentPath(const String& path)
     {
-        uint32_t pos = RemoveTrailingSlash(path).FindLast('/');
+        StringView trimmed = StringView(path).Trimmed();
+        if (trimmed.Back() == '/' || trimmed.Back() == '\\')
+            trimmed = trimmed.Substring(0, trimmed.Length() - 1);
+
+        const uint32_t pos = trimmed.FindLast('/', '\\');
         if (pos != String::NPOS)
-            return path.Substring(0, pos + 1);
+            return path.Substring(0, static_cast<uint32_t>(trimmed.Data() - path.CString()) + pos + 1);
 
         return String();
     }
@@ -194,13 +247,11 @@ namespace Alimer
         if (pathName.IsEmpty())
             return false;
 
-        String path = GetInternalPath(pathName);
-
-        if (path[0] == '/')
+        if (pathName[0] == '/' || pathName[0] == '\\')
             return true;
 
 #ifdef _WIN32
-        if (path.Length() > 1 && isalpha(path[0]) && path[1] == ':')
+        if (pathName.Length() > 1 && isalpha(pathName[0]) && pathName[1] == ':')
             return true;
 #endif
 
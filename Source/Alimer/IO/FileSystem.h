@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Base/String.h"
+#include "../Base/StringView.h"
 #include "../Core/Ptr.h"
 #include "../IO/Stream.h"
 #include <memory>
@@ -52,6 +53,17 @@ namespace Alimer
     /// Split a full path to path, filename and extension. The extension will be converted to lowercase by default.
     ALIMER_API void SplitPath(const String& fullPath, String& pathName, String& fileName, String& extension, bool lowerCaseExtension = true);
 
+    /// Split a full path to views of the path, filename and extension without allocating. Both slash kinds separate directories, the views keep them and the case of the extension as is.
+    ALIMER_API void SplitPath(StringView fullPath, StringView& pathName, StringView& fileName, StringView& extension);
+    /// Return view of the path, including the trailing slash, from a full path.
+    ALIMER_API StringView GetPathView(StringView fullPath);
+    /// Return view of the filename from a full path.
+    ALIMER_API StringView GetFileNameView(StringView fullPath);
+    /// Return view of the extension, including the dot, from a full path.
+    ALIMER_API StringView GetExtensionView(StringView fullPath);
+    /// Return view of the filename and extension from a full path.
+    ALIMER_API StringView GetFileNameAndExtensionView(StringView fullPath);
+
     /// Return the path from a full path.
     ALIMER_API String GetPath(const String& fullPath);
     /// Return the filename from a full path.
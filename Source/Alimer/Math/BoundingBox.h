@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Math/Math.h"
+#include <cfloat>
+#include <cmath>
+
+namespace Alimer
+{
+    /// Axis aligned bounding box.
+    struct BoundingBox
+    {
+        vec3 min;
+        vec3 max;
+
+        /// Construct empty (inverted) box.
+        BoundingBox()
+            : min(FLT_MAX, FLT_MAX, FLT_MAX)
+            , max(-FLT_MAX, -FLT_MAX, -FLT_MAX)
+        {
+        }
+
+        BoundingBox(const vec3& min_, const vec3& max_)
+            : min(min_)
+            , max(max_)
+        {
+        }
+
+        /// Return whether the box encloses no volume.
+        bool IsEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+        vec3 GetCenter() const { return (min + max) * 0.5f; }
+
+        /// Return half size.
+        vec3 GetExtents() const { return (max - min) * 0.5f; }
+
+        /// Enlarge to include point.
+        void Merge(const vec3& point)
+        {
+            min = Alimer::min(min, point);
+            max = Alimer::max(max, point);
+        }
+
+        /// Enlarge to include other box.
+        void Merge(const BoundingBox& box)
+        {
+            min = Alimer::min(min, box.min);
+            max = Alimer::max(max, box.max);
+        }
+
+        /// Return copy grown by margin on every side.
+        BoundingBox Inflated(float margin) const
+        {
+            const vec3 delta(margin, margin, margin);
+            return BoundingBox(min - delta, max + delta);
+        }
+
+        /// Return whether the other box lies completely inside.
+        bool Contains(const BoundingBox& box) const
+        {
+            return box.min.x >= min.x && box.min.y >= min.y && box.min.z >= min.z
+                && box.max.x <= max.x && box.max.y <= max.y && box.max.z <= max.z;
+        }
+
+        bool Contains(const vec3& point) const
+        {
+            return point.x >= min.x && point.y >= min.y && point.z >= min.z
+                && point.x <= max.x && point.y <= max.y && point.z <= max.z;
+        }
+
+        /// Return whether boxes overlap.
+        bool Intersects(const BoundingBox& box) const
+        {
+            return box.max.x >= min.x && box.max.y >= min.y && box.max.z >= min.z
+                && box.min.x <= max.x && box.min.y <= max.y && box.min.z <= max.z;
+        }
+
+        /// Return whether the box overlaps sphere.
+        bool Intersects(const vec3& center, float radius) const
+        {
+            const vec3 closest = clamp(center, min, max);
+            const vec3 delta = closest - center;
+            return dot(delta, delta) <= radius * radius;
+        }
+
+        /// Slab test against ray with precomputed reciprocal direction. Returns entry distance in hitDistance.
+        bool IntersectsRay(const vec3& origin, const vec3& invDirection, float maxDistance, float& hitDistance) const
+        {
+            const vec3 t0 = (min - origin) * invDirection;
+            const vec3 t1 = (max - origin) * invDirection;
+            const vec3 tmin = Alimer::min(t0, t1);
+            const vec3 tmax = Alimer::max(t0, t1);
+
+            const float enter = std::max(std::max(tmin.x, tmin.y), std::max(tmin.z, 0.0f));
+            const float exit = std::min(std::min(tmax.x, tmax.y), std::min(tmax.z, maxDistance));
+            hitDistance = enter;
+            return enter <= exit;
+        }
+
+        /// Return box enclosing this box transformed by matrix.
+        BoundingBox Transformed(const mat4& transform) const
+        {
+            const vec3 center = GetCenter();
+            const vec3 extents = GetExtents();
+
+            vec3 newCenter;
+            vec3 newExtents;
+            for (int i = 0; i < 3; ++i)
+            {
+                newCenter[i] = transform[0][i] * center.x + transform[1][i] * center.y + transform[2][i] * center.z + transform[3][i];
+                newExtents[i] = std::abs(transform[0][i]) * extents.x + std::abs(transform[1][i]) * extents.y + std::abs(transform[2][i]) * extents.z;
+            }
+
+            return BoundingBox(newCenter - newExtents, newCenter + newExtents);
+        }
+    };
+}
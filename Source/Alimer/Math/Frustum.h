@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Math/BoundingBox.h"
+
+namespace Alimer
+{
+    /// View frustum as six inward facing planes (normal, distance).
+    struct Frustum
+    {
+        enum PlaneIndex
+        {
+            Left,
+            Right,
+            Bottom,
+            Top,
+            Near,
+            Far,
+            Count
+        };
+
+        vec4 planes[Count];
+
+        Frustum() = default;
+
+        /// Extract planes from view projection matrix with zero to one clip depth.
+        explicit Frustum(const mat4& viewProjection)
+        {
+            const vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+            const vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+            const vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+            const vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+            planes[Left] = row3 + row0;
+            planes[Right] = row3 - row0;
+            planes[Bottom] = row3 + row1;
+            planes[Top] = row3 - row1;
+            planes[Near] = row2;
+            planes[Far] = row3 - row2;
+
+            for (vec4& plane : planes)
+            {
+                const float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+                plane = plane * (1.0f / length);
+            }
+        }
+
+        /// Return whether box is at least partially inside. Tests the corner furthest along each plane normal.
+        bool Intersects(const BoundingBox& box) const
+        {
+            for (const vec4& plane : planes)
+            {
+                const float x = plane.x >= 0.0f ? box.max.x : box.min.x;
+                const float y = plane.y >= 0.0f ? box.max.y : box.min.y;
+                const float z = plane.z >= 0.0f ? box.max.z : box.min.z;
+                if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f)
+                    return false;
+            }
+
+            return true;
+        }
+    };
+}
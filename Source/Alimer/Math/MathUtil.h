@@ -190,6 +190,21 @@ namespace Alimer
 #endif
     }
 
+    inline uint32_t ScanForward64(uint64_t bits)
+    {
+        ALIMER_ASSERT(bits != 0);
+#if defined(_MSC_VER) && defined(_WIN64)
+        unsigned long firstBitIndex = 0ul;
+        _BitScanForward64(&firstBitIndex, bits);
+        return firstBitIndex;
+#elif defined(_MSC_VER)
+        const uint32_t low = static_cast<uint32_t>(bits);
+        return low ? ScanForward(low) : 32u + ScanForward(static_cast<uint32_t>(bits >> 32));
+#else
+        return static_cast<uint32_t>(__builtin_ctzll(bits));
+#endif
+    }
+
     template <typename T> ALIMER_FORCE_INLINE T AlignUpWithMask(T value, size_t mask)
     {
         return (T)(((size_t)value + mask) & ~mask);
@@ -272,6 +287,16 @@ namespace Alimer
         }
     }
 
+    template<typename T>
+    inline void ForEachBit64(uint64_t value, const T &func)
+    {
+        while (value)
+        {
+            func(ScanForward64(value));
+            value &= value - 1;
+        }
+    }
+
     template<typename T>
     inline void ForEachBitRange(uint32_t value, const T &func)
     {
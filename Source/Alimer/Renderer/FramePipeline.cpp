@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Renderer/FramePipeline.h"
+#include "../Core/Platform.h"
+using namespace std;
+
+namespace Alimer
+{
+    FramePipeline::FramePipeline()
+    {
+    }
+
+    FramePipeline::~FramePipeline()
+    {
+        Stop();
+    }
+
+    void FramePipeline::Start(RenderFunction func)
+    {
+        Stop();
+
+        _render = std::move(func);
+#if ALIMER_THREADING
+        _shutdown = false;
+        _thread = thread(&FramePipeline::RenderThread, this);
+#endif
+    }
+
+    void FramePipeline::Stop()
+    {
+        if (!_thread.joinable())
+            return;
+
+        {
+            unique_lock<mutex> lock(_mutex);
+            _shutdown = true;
+        }
+        _condition.notify_all();
+        _thread.join();
+    }
+
+    void FramePipeline::Submit()
+    {
+        {
+            unique_lock<mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _pending == nullptr; });
+            _pending = &_frames[_extractIndex];
+        }
+        _condition.notify_all();
+
+        // The other buffer was released by the frame that just finished rendering.
+        _extractIndex = 1 - _extractIndex;
+    }
+
+    void FramePipeline::WaitIdle()
+    {
+        unique_lock<mutex> lock(_mutex);
+        _condition.wait(lock, [this]() { return _pending == nullptr; });
+    }
+
+    void FramePipeline::RenderThread()
+    {
+        SetCurrentThreadName("Render");
+
+        unique_lock<mutex> lock(_mutex);
+        for (;;)
+        {
+            _condition.wait(lock, [this]() { return _pending != nullptr || _shutdown; });
+            if (!_pending)
+                break;
+
+            const RenderFrameData* frame = _pending;
+            lock.unlock();
+            _render(*frame);
+            lock.lock();
+
+            _pending = nullptr;
+            _condition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Renderer/RenderFrameData.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Alimer
+{
+    /// Two stage frame pipeline: the render thread draws frame N from an extracted copy while the main thread
+    /// simulates frame N + 1. Render data is double buffered; Submit is the only sync point, waiting for the
+    /// render thread to finish the previous frame before handing over the next one.
+    class ALIMER_API FramePipeline final
+    {
+    public:
+        using RenderFunction = std::function<void(const RenderFrameData&)>;
+
+        /// Constructor.
+        FramePipeline();
+
+        /// Destructor. Stops the render thread.
+        ~FramePipeline();
+
+        /// Start render thread invoking func for every submitted frame. Without threading support nothing is started
+        /// and frames are expected to be rendered directly.
+        void Start(RenderFunction func);
+
+        /// Render the last submitted frame and join the render thread.
+        void Stop();
+
+        /// Return whether the render thread runs.
+        bool IsRunning() const { return _thread.joinable(); }
+
+        /// Return buffer to fill at the extract point. The render thread does not read it until Submit.
+        RenderFrameData& GetExtractFrame() { return _frames[_extractIndex]; }
+
+        /// Hand the extracted frame over to the render thread, waiting for the previous frame to finish rendering.
+        void Submit();
+
+        /// Wait until every submitted frame has been rendered.
+        void WaitIdle();
+
+    private:
+        void RenderThread();
+
+        /// Double buffered frame data.
+        RenderFrameData _frames[2];
+        /// Buffer being filled by the main thread.
+        uint32_t _extractIndex = 0;
+        RenderFunction _render;
+        std::thread _thread;
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        /// Frame submitted and not yet rendered, null when the render thread is idle.
+        const RenderFrameData* _pending = nullptr;
+        bool _shutdown = false;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(FramePipeline);
+    };
+}
@@ -37,8 +37,14 @@ namespace Alimer
 
         void SetDevice(GraphicsDevice* device);
 
+        /// Set blend factor between the previous and the latest fixed simulation step.
+        void SetInterpolationAlpha(float alpha) { _interpolationAlpha = alpha; }
+        /// Return blend factor between the previous and the latest fixed simulation step, one without fixed timestep.
+        float GetInterpolationAlpha() const { return _interpolationAlpha; }
+
     private:
         /// Graphics subsystem.
         GraphicsDevice* _device;
+        float _interpolationAlpha = 1.0f;
     };
 }
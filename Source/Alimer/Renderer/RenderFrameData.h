@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Base/FrameAllocator.h"
+#include "../Scene/Entity.h"
+#include "../Math/BoundingBox.h"
+
+namespace Alimer
+{
+    /// Camera state extracted for rendering.
+    struct RenderView
+    {
+        Entity::Id camera;
+        mat4 view;
+        mat4 projection;
+    };
+
+    /// Renderable entity state extracted for rendering.
+    struct RenderItem
+    {
+        Entity::Id entity;
+        mat4 world;
+        /// World space bounds.
+        BoundingBox bounds;
+    };
+
+    /// Everything rendering needs from one simulated frame. Filled on the main thread at the extract point
+    /// and only read afterwards, so the render thread never touches live entity data. Lists live in frame
+    /// allocator memory, which outlasts the frames in flight.
+    struct RenderFrameData
+    {
+        uint64_t frameIndex = 0;
+        double frameTime = 0.0;
+        double elapsedTime = 0.0;
+        /// Blend factor between the previous and the latest fixed simulation step.
+        float interpolationAlpha = 1.0f;
+        FrameVector<RenderView> views;
+        FrameVector<RenderItem> items;
+
+        /// Remove extracted data and rebind the lists to the current frame, reserving the previous counts.
+        void Clear(FrameAllocator& allocator)
+        {
+            const size_t viewCount = views.size();
+            const size_t itemCount = items.size();
+            views = FrameVector<RenderView>(FrameStlAllocator<RenderView>(&allocator));
+            items = FrameVector<RenderItem>(FrameStlAllocator<RenderItem>(&allocator));
+            views.reserve(viewCount);
+            items.reserve(itemCount);
+        }
+    };
+}
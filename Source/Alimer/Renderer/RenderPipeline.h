@@ -27,7 +27,7 @@
 namespace Alimer
 {
     class RenderContext;
-    class Camera;
+    struct RenderFrameData;
 
     /// Defines a base class for rendering pipeline.
     class ALIMER_API RenderPipeline : public Object
@@ -38,7 +38,8 @@ namespace Alimer
         RenderPipeline();
         virtual ~RenderPipeline() = default;
 
-        virtual void Render(const RenderContext &context, std::vector<Camera> cameras) = 0;
+        /// Render the views of an extracted frame. Runs on the render thread when pipelined, so only the frame data may be read.
+        virtual void Render(const RenderContext &context, const RenderFrameData& frame) = 0;
 
     private:
     };
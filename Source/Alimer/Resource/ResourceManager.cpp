@@ -133,7 +133,17 @@ namespace Alimer
 
     SharedPtr<Resource> ResourceManager::LoadResource(const String& assetName)
     {
-        ALIMER_UNUSED(assetName);
+        // Look up without interning, names enter the table only when a resource is stored under them.
+        const String sanitatedName = SanitateResourceName(assetName);
+        const Name name = Name::Find(sanitatedName.CString(), sanitatedName.Length());
+        if (!name.IsEmpty())
+        {
+            std::lock_guard<std::mutex> guard(_resourceMutex);
+            auto it = _resources.find(name);
+            if (it != _resources.end())
+                return it->second;
+        }
+
         /*auto paths = Path::ProtocolSplit(assetName);
         string fullPath = Path::Join(_dataDirectory, paths.second);
         string compiledAssetName = fullPath + ".alb";
@@ -153,30 +163,40 @@ namespace Alimer
     String ResourceManager::SanitateResourceName(const String& name) const
     {
         // Sanitate unsupported constructs from the resource name
-        String sanitatedName = name.Replaced("../", "");
+        String sanitatedName = name;
+        sanitatedName.Replace("../", "");
         sanitatedName.Replace("./", "");
 
         // If the path refers to one of the resource directories, normalize the resource name
         if (_resourceDirs.size())
         {
-            String namePath = GetPath(sanitatedName);
-            String exePath = GetExecutableFolder().Replaced("/./", "/");
-            for (size_t i = 0; i < _resourceDirs.size(); ++i)
+            sanitatedName.Replace('\\', '/');
+
+            StringView namePath = GetPathView(sanitatedName);
+            const String exePath = GetExecutableFolder().Replaced("/./", "/");
+            for (const String& resourceDir : _resourceDirs)
             {
-                String relativeResourcePath = _resourceDirs[i];
+                StringView relativeResourcePath(resourceDir);
                 if (relativeResourcePath.StartsWith(exePath))
                     relativeResourcePath = relativeResourcePath.Substring(exePath.Length());
 
-                if (namePath.StartsWith(_resourceDirs[i], false))
-                    namePath = namePath.Substring(_resourceDirs[i].Length());
-                else if (namePath.StartsWith(relativeResourcePath, false))
+                if (namePath.StartsWith(resourceDir, false))
+                    namePath = namePath.Substring(resourceDir.Length());
+                else if (!relativeResourcePath.IsEmpty() && namePath.StartsWith(relativeResourcePath, false))
                     namePath = namePath.Substring(relativeResourcePath.Length());
             }
 
-            sanitatedName = namePath + GetFileNameAndExtension(sanitatedName);
+            // The stripped directories are a prefix of the name, erase them in place
+            const uint32_t prefixLength = static_cast<uint32_t>(namePath.Data() - sanitatedName.CString());
+            if (prefixLength)
+                sanitatedName.Erase(0, prefixLength);
         }
 
-        return sanitatedName.Trimmed();
+        const StringView trimmed = StringView(sanitatedName).Trimmed();
+        if (trimmed.Length() != sanitatedName.Length())
+            sanitatedName = trimmed.ToString();
+
+        return sanitatedName;
     }
 
     String ResourceManager::SanitateResourceDirName(const String& name) const
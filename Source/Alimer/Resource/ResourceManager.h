@@ -24,10 +24,11 @@
 
 #include "../IO/FileSystem.h"
 #include "../Resource/ResourceLoader.h"
+#include "../Base/Name.h"
 #include <mutex>
 #include <atomic>
 #include <vector>
-#include <map>
+#include <unordered_map>
 
 namespace Alimer
 {
@@ -81,7 +82,8 @@ namespace Alimer
         /// Resource load directories.
         std::vector<String> _resourceDirs;
 
-		std::map<String, SharedPtr<Resource>> _resources;
+        /// Loaded resources by interned sanitated name.
+		std::unordered_map<Name, SharedPtr<Resource>> _resources;
 
         /// Search priority flag.
         bool _searchPackagesFirst{ true };
@@ -0,0 +1,329 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../AlimerConfig.h"
+#include "../Math/MathUtil.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <utility>
+
+namespace Alimer
+{
+    /// Growable set of component families. The first 64 families are stored inline,
+    /// higher families in a heap block allocated on demand. Interface follows std::bitset.
+    class ComponentMask final
+    {
+    public:
+        /// Construct empty mask.
+        ComponentMask() = default;
+
+        ComponentMask(const ComponentMask& other)
+            : _bits(other._bits)
+        {
+            CopyExtra(other);
+        }
+
+        ComponentMask(ComponentMask&& other) noexcept
+            : _bits(other._bits)
+            , _extra(other._extra)
+        {
+            other._bits = 0;
+            other._extra = nullptr;
+        }
+
+        ~ComponentMask()
+        {
+            delete[] _extra;
+        }
+
+        ComponentMask& operator =(const ComponentMask& other)
+        {
+            if (this != &other)
+            {
+                _bits = other._bits;
+                CopyExtra(other);
+            }
+            return *this;
+        }
+
+        ComponentMask& operator =(ComponentMask&& other) noexcept
+        {
+            std::swap(_bits, other._bits);
+            std::swap(_extra, other._extra);
+            return *this;
+        }
+
+        /// Return whether family bit is set.
+        bool test(size_t bit) const
+        {
+            return (GetWord(bit / 64) >> (bit % 64)) & 1u;
+        }
+
+        /// Set family bit.
+        ComponentMask& set(size_t bit)
+        {
+            const size_t word = bit / 64;
+            if (word == 0)
+            {
+                _bits |= uint64_t(1) << bit;
+            }
+            else
+            {
+                Reserve(word);
+                _extra[word] |= uint64_t(1) << (bit % 64);
+            }
+            return *this;
+        }
+
+        /// Clear family bit.
+        ComponentMask& reset(size_t bit)
+        {
+            const size_t word = bit / 64;
+            if (word == 0)
+            {
+                _bits &= ~(uint64_t(1) << bit);
+            }
+            else if (word <= GetExtraCount())
+            {
+                _extra[word] &= ~(uint64_t(1) << (bit % 64));
+            }
+            return *this;
+        }
+
+        /// Clear all bits.
+        ComponentMask& reset()
+        {
+            _bits = 0;
+            if (_extra)
+            {
+                std::memset(_extra + 1, 0, GetExtraCount() * sizeof(uint64_t));
+            }
+            return *this;
+        }
+
+        /// Return whether any bit is set.
+        bool any() const
+        {
+            if (_bits)
+                return true;
+
+            const size_t count = GetExtraCount();
+            for (size_t i = 1; i <= count; ++i)
+            {
+                if (_extra[i])
+                    return true;
+            }
+            return false;
+        }
+
+        /// Return whether no bit is set.
+        bool none() const { return !any(); }
+
+        /// Return whether every bit of other is also set in this mask.
+        bool Contains(const ComponentMask& other) const
+        {
+            if ((_bits & other._bits) != other._bits)
+                return false;
+
+            const size_t count = other.GetExtraCount();
+            for (size_t i = 1; i <= count; ++i)
+            {
+                const uint64_t word = other._extra[i];
+                if ((GetWord(i) & word) != word)
+                    return false;
+            }
+            return true;
+        }
+
+        /// Return whether any bit is set in both masks.
+        bool Intersects(const ComponentMask& other) const
+        {
+            if (_bits & other._bits)
+                return true;
+
+            const size_t count = std::min(GetExtraCount(), other.GetExtraCount());
+            for (size_t i = 1; i <= count; ++i)
+            {
+                if (_extra[i] & other._extra[i])
+                    return true;
+            }
+            return false;
+        }
+
+        /// Invoke func(family) for every set bit in ascending order.
+        template <typename Function>
+        void ForEachSetBit(Function&& func) const
+        {
+            ForEachBit64(_bits, func);
+
+            const size_t count = GetExtraCount();
+            for (size_t i = 1; i <= count; ++i)
+            {
+                const uint32_t base = static_cast<uint32_t>(i * 64);
+                ForEachBit64(_extra[i], [&func, base](uint32_t bit) { func(base + bit); });
+            }
+        }
+
+        /// Return 64 bit word by index, zero past the allocated words.
+        uint64_t GetWord(size_t index) const
+        {
+            if (index == 0)
+                return _bits;
+
+            return index <= GetExtraCount() ? _extra[index] : 0;
+        }
+
+        /// Return number of 64 bit words, including the inline one.
+        size_t GetWordCount() const { return 1 + GetExtraCount(); }
+
+        ComponentMask& operator &=(const ComponentMask& other)
+        {
+            _bits &= other._bits;
+            const size_t count = GetExtraCount();
+            for (size_t i = 1; i <= count; ++i)
+            {
+                _extra[i] &= other.GetWord(i);
+            }
+            return *this;
+        }
+
+        ComponentMask& operator |=(const ComponentMask& other)
+        {
+            _bits |= other._bits;
+            const size_t count = other.GetExtraCount();
+            if (count)
+            {
+                Reserve(count);
+                for (size_t i = 1; i <= count; ++i)
+                {
+                    _extra[i] |= other._extra[i];
+                }
+            }
+            return *this;
+        }
+
+        bool operator ==(const ComponentMask& other) const
+        {
+            if (_bits != other._bits)
+                return false;
+
+            const size_t count = std::max(GetExtraCount(), other.GetExtraCount());
+            for (size_t i = 1; i <= count; ++i)
+            {
+                if (GetWord(i) != other.GetWord(i))
+                    return false;
+            }
+            return true;
+        }
+
+        bool operator !=(const ComponentMask& other) const { return !(*this == other); }
+
+        /// Return hash value, independent of trailing zero words.
+        size_t ToHash() const
+        {
+            size_t hash = std::hash<uint64_t>()(_bits);
+            const size_t count = GetExtraCount();
+            for (size_t i = 1; i <= count; ++i)
+            {
+                if (_extra[i])
+                {
+                    hash ^= std::hash<uint64_t>()(_extra[i] + i) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+                }
+            }
+            return hash;
+        }
+
+    private:
+        /// Number of heap words, stored in the first element of the heap block.
+        size_t GetExtraCount() const { return _extra ? static_cast<size_t>(_extra[0]) : 0; }
+
+        /// Ensure heap words up to index exist.
+        void Reserve(size_t index)
+        {
+            const size_t count = GetExtraCount();
+            if (index <= count)
+                return;
+
+            uint64_t* extra = new uint64_t[index + 1];
+            extra[0] = index;
+            if (count)
+            {
+                std::memcpy(extra + 1, _extra + 1, count * sizeof(uint64_t));
+            }
+            std::memset(extra + 1 + count, 0, (index - count) * sizeof(uint64_t));
+
+            delete[] _extra;
+            _extra = extra;
+        }
+
+        void CopyExtra(const ComponentMask& other)
+        {
+            const size_t count = other.GetExtraCount();
+            if (!count)
+            {
+                if (_extra)
+                {
+                    std::memset(_extra + 1, 0, GetExtraCount() * sizeof(uint64_t));
+                }
+                return;
+            }
+
+            Reserve(count);
+            std::memcpy(_extra + 1, other._extra + 1, count * sizeof(uint64_t));
+            std::memset(_extra + 1 + count, 0, (GetExtraCount() - count) * sizeof(uint64_t));
+        }
+
+        /// Families [0, 64).
+        uint64_t _bits = 0;
+        /// Heap block for families from 64 on: word count followed by the words.
+        uint64_t* _extra = nullptr;
+    };
+
+    inline ComponentMask operator &(const ComponentMask& lhs, const ComponentMask& rhs)
+    {
+        ComponentMask result(lhs);
+        result &= rhs;
+        return result;
+    }
+
+    inline ComponentMask operator |(const ComponentMask& lhs, const ComponentMask& rhs)
+    {
+        ComponentMask result(lhs);
+        result |= rhs;
+        return result;
+    }
+}
+
+namespace std
+{
+    template <> struct hash<Alimer::ComponentMask>
+    {
+        std::size_t operator()(const Alimer::ComponentMask& mask) const
+        {
+            return mask.ToHash();
+        }
+    };
+}
@@ -25,11 +25,6 @@
 
 namespace Alimer
 {
-    CameraComponent::~CameraComponent()
-    {
-
-    }
-
     void CameraComponent::Update(const Transform& transform)
     {
         _projection = mat4::perspective(ToRadians(fovy), aspect, znear, zfar);
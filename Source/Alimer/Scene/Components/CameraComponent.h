@@ -28,14 +28,11 @@
 
 namespace Alimer
 {
-	/// Defines a Camera Component class.
-    class ALIMER_API CameraComponent final : public Component<CameraComponent>
+	/// Defines a Camera Component class, stored by value in archetype chunks.
+    class ALIMER_API CameraComponent final
 	{
-        // ALIMER_OBJECT(CameraComponent, Component);
-
     public:
         CameraComponent() = default;
-        virtual ~CameraComponent();
 
         void Update(const Transform& transform);
 
@@ -50,60 +50,40 @@ namespace Alimer
         return true;
     }
 
-    TransformComponent::~TransformComponent()
+    mat4 TransformComponent::ComputeWorldMatrix() const
     {
+        if (_parent.IsValid())
+        {
+            auto parentTransform = _parent.GetComponent<TransformComponent>();
+            if (parentTransform)
+            {
+                return parentTransform->ComputeWorldMatrix() * _localTransform.GetMatrix();
+            }
+        }
 
+        return _localTransform.GetMatrix();
     }
 
     void TransformComponent::UpdateWorldTransform(bool force)
     {
+        // The dirty flag is left for the TransformSystem, which propagates it to the children.
         if (force || IsDirty())
         {
-            if (_parent.IsValid())
-            {
-                auto parentTransform = _parent.GetComponent<TransformComponent>();
-                if (parentTransform)
-                {
-                    //_worldTransform = parentTransform->GetTransform() * _localTransform;
-                }
-                else
-                {
-                    _worldTransform = _localTransform;
-                }
-            }
-            else
-            {
-                _worldTransform = _localTransform;
-            }
-
-            SetDirty(false);
+            _worldTransform = Transform(ComputeWorldMatrix());
         }
     }
 
     void TransformComponent::SetDirty(bool dirty)
     {
+        // Children are reached by the TransformSystem in its linear propagation pass.
         _dirty = dirty;
-
-        if (_dirty)
-        {
-            for (const Entity& child : _children)
-            {
-                if (child.IsValid())
-                {
-                    auto childTransform = child.GetComponent<TransformComponent>();
-                    if (childTransform)
-                    {
-                        childTransform->SetDirty(dirty);
-                    }
-                }
-            }
-        }
     }
 
-    void TransformComponent::SetParent(Entity parent)
+    void TransformComponent::SetParent(Entity entity, Entity parent)
     {
         // Check if parent is valid.
-        if (!CheckValidParent(_entity, parent))
+        TransformComponent* transform = entity.IsValid() ? entity.GetComponent<TransformComponent>() : nullptr;
+        if (!transform || !CheckValidParent(entity, parent))
         {
             return;
         }
@@ -112,48 +92,47 @@ namespace Alimer
         const bool keepWorldTransform = true;
         if (keepWorldTransform)
         {
-            UpdateWorldTransform(true);
-            cachedWorldTransform = GetTransform();
+            transform->UpdateWorldTransform(true);
+            cachedWorldTransform = transform->GetTransform();
         }
 
-        if (_parent.IsValid())
+        if (transform->_parent.IsValid())
         {
-            auto parentTransform = _parent.GetComponent<TransformComponent>();
+            auto parentTransform = transform->_parent.GetComponent<TransformComponent>();
             if (parentTransform)
             {
-                parentTransform->RemoveChild(_entity);
+                parentTransform->RemoveChild(entity);
             }
         }
 
-        _parent = parent;
+        transform->_parent = parent;
+        entity.MarkStructureChanged<TransformComponent>();
 
-        if (_parent.IsValid())
+        if (transform->_parent.IsValid())
         {
-            auto parentTransform = _parent.GetComponent<TransformComponent>();
+            auto parentTransform = transform->_parent.GetComponent<TransformComponent>();
             if (parentTransform)
             {
-                parentTransform->AddChild(_entity);
+                parentTransform->AddChild(entity);
             }
         }
 
         if (keepWorldTransform)
         {
-            UpdateWorldTransform(true);
-            SetTransform(cachedWorldTransform);
+            transform->UpdateWorldTransform(true);
+            transform->SetTransform(cachedWorldTransform);
         }
         else
         {
-           SetLocalTransform(Transform::Identity);
+            transform->SetLocalTransform(Transform::Identity);
         }
 
-        SetDirty(IsDirty());
+        transform->SetDirty(true);
     }
 
     void TransformComponent::AddChild(const Entity& child)
     {
         _children.push_back(child);
-
-        SetDirty(IsDirty());
     }
 
     void TransformComponent::RemoveChild(const Entity& child)
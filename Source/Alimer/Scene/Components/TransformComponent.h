@@ -29,19 +29,20 @@
 
 namespace Alimer
 {
-	/// Defines a Transform Component.
-    class ALIMER_API TransformComponent final : public Component<TransformComponent>
+	/// Defines a Transform Component, stored by value in archetype chunks.
+    /// World transforms are refreshed once per frame by the TransformSystem.
+    class ALIMER_API TransformComponent final
 	{
-        //ALIMER_OBJECT(TransformComponent, Component);
+        friend class TransformSystem;
 
     public:
         TransformComponent() = default;
-        virtual ~TransformComponent();
 
+        /// Recompute world transform from the parent chain now, if dirty or forced.
         void UpdateWorldTransform(bool force = false);
 
-        /// Set parent entity
-        void SetParent(Entity parent);
+        /// Set parent entity of an entity owning a transform.
+        static void SetParent(Entity entity, Entity parent);
 
         /// Get all chidrens.
         const std::vector<Entity>& GetChildren() const { return _children; }
@@ -55,13 +56,15 @@ namespace Alimer
         /// Set transform in local space.
         void SetLocalTransform(const Transform& transform);
 
-        /// Get transform in world space.
+        /// Get transform in world space. Changes of ancestors are visible after the next TransformSystem update.
         const Transform& GetTransform();
 
         /// Get transform in local space.
         const Transform& GetLocalTransform() const;
 
     private:
+        /// Compose local matrices up the parent chain.
+        mat4 ComputeWorldMatrix() const;
         void AddChild(const Entity& child);
         void RemoveChild(const Entity& child);
 
@@ -73,7 +76,7 @@ namespace Alimer
         Transform _localTransform;
         /// Cached world transformation at pivot point.
         Transform _worldTransform;
-        /// Transform dirty state.
+        /// Local transform changed since the last TransformSystem update.
         bool _dirty = true;
 	};
 }
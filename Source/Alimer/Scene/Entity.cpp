@@ -21,57 +21,399 @@
 //
 
 #include "../Scene/Entity.h"
+#include "../Scene/EntityCommandBuffer.h"
+#include "../Scene/EntitySnapshot.h"
 #include "../Core/Log.h"
 using namespace std;
 
 namespace Alimer
 {
-    uint32_t ComponentIDMapping::ids;
+    std::atomic<uint32_t> ComponentIDMapping::ids{ 0 };
+
+    // EntitySparseSet
+    constexpr uint32_t EntitySparseSet::NPOS;
+    constexpr uint32_t EntitySparseSet::PAGE_SIZE;
+
+    uint32_t EntitySparseSet::Insert(Entity::Id id)
+    {
+        uint32_t& sparse = GetSparse(id.index());
+        if (sparse != NPOS)
+        {
+            _entities[sparse] = id;
+            return sparse;
+        }
+
+        sparse = static_cast<uint32_t>(_entities.size());
+        _entities.push_back(id);
+        return sparse;
+    }
+
+    uint32_t EntitySparseSet::Erase(uint32_t index)
+    {
+        if (GetPosition(index) == NPOS)
+            return NPOS;
+
+        uint32_t& sparse = GetSparse(index);
+        const uint32_t position = sparse;
+
+        const uint32_t last = static_cast<uint32_t>(_entities.size() - 1);
+        if (position != last)
+        {
+            _entities[position] = _entities[last];
+            GetSparse(_entities[position].index()) = position;
+        }
+
+        sparse = NPOS;
+        _entities.pop_back();
+        return position;
+    }
+
+    void EntitySparseSet::Clear()
+    {
+        _sparse.clear();
+        _entities.clear();
+    }
+
+    uint32_t& EntitySparseSet::GetSparse(uint32_t index)
+    {
+        const uint32_t page = index / PAGE_SIZE;
+        if (page >= _sparse.size())
+        {
+            _sparse.resize(page + 1);
+        }
+
+        if (!_sparse[page])
+        {
+            _sparse[page].reset(new uint32_t[PAGE_SIZE]);
+            std::fill(_sparse[page].get(), _sparse[page].get() + PAGE_SIZE, NPOS);
+        }
+
+        return _sparse[page][index % PAGE_SIZE];
+    }
 
     // ComponentStorage
-    ComponentStorage::ComponentStorage(std::size_t size)
+    // EntityNameTable
+    constexpr uint32_t EntityNameTable::NPOS;
+
+    void EntityNameTable::Set(Entity::Id id, const Name& name)
+    {
+        const uint32_t index = id.index();
+        if (index < _slots.size() && !_slots[index].name.IsEmpty())
+        {
+            if (_slots[index].name == name)
+            {
+                _slots[index].id = id;
+                return;
+            }
+
+            Remove(index);
+        }
+
+        if (name.IsEmpty())
+            return;
+
+        if (index >= _slots.size())
+        {
+            _slots.resize(std::max<size_t>(index + 1, _slots.size() * 2));
+        }
+
+        // Link in front, so Find returns the most recently named entity.
+        auto it = _first.emplace(name, NPOS).first;
+        Slot& slot = _slots[index];
+        slot.name = name;
+        slot.id = id;
+        slot.prev = NPOS;
+        slot.next = it->second;
+        if (it->second != NPOS)
+        {
+            _slots[it->second].prev = index;
+        }
+        it->second = index;
+    }
+
+    void EntityNameTable::Remove(uint32_t index)
+    {
+        if (index >= _slots.size() || _slots[index].name.IsEmpty())
+            return;
+
+        Slot& slot = _slots[index];
+        if (slot.prev != NPOS)
+        {
+            _slots[slot.prev].next = slot.next;
+        }
+        else if (slot.next != NPOS)
+        {
+            _first[slot.name] = slot.next;
+        }
+        else
+        {
+            _first.erase(slot.name);
+        }
+
+        if (slot.next != NPOS)
+        {
+            _slots[slot.next].prev = slot.prev;
+        }
+
+        slot = Slot();
+    }
+
+    void EntityNameTable::Clear()
     {
-        Expand(size);
+        _first.clear();
+        _slots.clear();
     }
 
-    void ComponentStorage::Expand(std::size_t size)
+    Entity::Id EntityNameTable::Find(const Name& name) const
     {
-        _data.resize(size);
+        auto it = _first.find(name);
+        if (it == _first.end())
+            return Entity::INVALID;
+
+        return _slots[it->second].id;
     }
 
     void ComponentStorage::Reserve(std::size_t size)
     {
-        _data.reserve(size);
+        _dense.reserve(size);
+        _versions.reserve(size);
+        _entities.Reserve(size);
+    }
+
+    BaseComponent* ComponentStorage::Get(uint32_t index)
+    {
+        const uint32_t position = _entities.GetPosition(index);
+        return position != EntitySparseSet::NPOS ? _dense[position].Get() : nullptr;
+    }
+
+    void ComponentStorage::Destroy(uint32_t index)
+    {
+        // Keep the component alive until the set is consistent, its destructor may query the entity manager.
+        const uint32_t position = _entities.Erase(index);
+        if (position == EntitySparseSet::NPOS)
+            return;
+
+        IntrusivePtr<BaseComponent> removed = _dense[position];
+        _dense[position] = std::move(_dense.back());
+        _dense.pop_back();
+        _versions[position] = _versions.back();
+        _versions.pop_back();
+    }
+
+    void ComponentStorage::Set(Entity::Id id, const IntrusivePtr<BaseComponent>& component)
+    {
+        const uint32_t position = _entities.Insert(id);
+        if (position == _dense.size())
+        {
+            _dense.push_back(component);
+            _versions.emplace_back();
+        }
+        else
+        {
+            _dense[position] = component;
+        }
+    }
+
+    void ComponentStorage::Clear()
+    {
+        // Release after the set is empty, component destructors may query the entity manager.
+        std::vector<IntrusivePtr<BaseComponent>> released;
+        released.swap(_dense);
+        _versions.clear();
+        _entities.Clear();
+    }
+
+    // Archetype
+    constexpr uint32_t Archetype::NPOS;
+
+    Archetype::Archetype(const ComponentMask& mask, std::vector<const ComponentTypeInfo*> types)
+        : _mask(mask)
+        , _types(std::move(types))
+    {
+        uint32_t rowSize = sizeof(Entity::Id);
+        uint32_t maxFamily = 0;
+        for (const ComponentTypeInfo* type : _types)
+        {
+            assert(type->alignment <= alignof(std::max_align_t) && "Over-aligned components are not supported");
+            rowSize += type->size + sizeof(ComponentVersion);
+            maxFamily = std::max(maxFamily, type->family);
+        }
+
+        // Shrink capacity until arrays fit with their alignment padding.
+        _chunkCapacity = ARCHETYPE_CHUNK_SIZE / rowSize;
+        _offsets.resize(_types.size());
+        while (_chunkCapacity > 0)
+        {
+            uint32_t offset = _chunkCapacity * sizeof(Entity::Id);
+            for (size_t i = 0; i < _types.size(); ++i)
+            {
+                const uint32_t alignment = _types[i]->alignment;
+                offset = (offset + alignment - 1) & ~(alignment - 1);
+                _offsets[i] = offset;
+                offset += _chunkCapacity * _types[i]->size;
+            }
+
+            const uint32_t versionAlignment = alignof(ComponentVersion);
+            _versionOffset = (offset + versionAlignment - 1) & ~(versionAlignment - 1);
+            offset = _versionOffset + _chunkCapacity * static_cast<uint32_t>(_types.size() * sizeof(ComponentVersion));
+
+            if (offset <= ARCHETYPE_CHUNK_SIZE)
+                break;
+
+            --_chunkCapacity;
+        }
+
+        assert(_chunkCapacity > 0 && "Archetype row does not fit in a chunk");
+
+        _typeIndex.resize(maxFamily + 1, NPOS);
+        for (size_t i = 0; i < _types.size(); ++i)
+        {
+            _typeIndex[_types[i]->family] = static_cast<uint32_t>(i);
+        }
+    }
+
+    Archetype::~Archetype()
+    {
+        for (uint32_t i = 0; i < GetChunkCount(); ++i)
+        {
+            for (uint32_t row = 0; row < _chunks[i].count; ++row)
+            {
+                DestructRow(i, row);
+            }
+
+            free(_chunks[i].data);
+        }
+
+        free(_spareChunk);
+    }
+
+    void Archetype::Allocate(Entity::Id id, uint32_t& chunkIndex, uint32_t& row)
+    {
+        if (_chunks.empty() || _chunks.back().count == _chunkCapacity)
+        {
+            ArchetypeChunk chunk;
+            chunk.count = 0;
+            if (_spareChunk)
+            {
+                chunk.data = _spareChunk;
+                _spareChunk = nullptr;
+            }
+            else
+            {
+                chunk.data = static_cast<uint8_t*>(malloc(ARCHETYPE_CHUNK_SIZE));
+            }
+
+            chunk.versions.reset(new std::atomic<uint32_t>[_types.size()]);
+            for (size_t i = 0; i < _types.size(); ++i)
+            {
+                chunk.versions[i].store(0, std::memory_order_relaxed);
+            }
+
+            _chunks.push_back(std::move(chunk));
+        }
+
+        chunkIndex = GetChunkCount() - 1;
+        ArchetypeChunk& chunk = _chunks.back();
+        row = chunk.count++;
+        GetEntities(chunk)[row] = id;
+        for (uint32_t i = 0; i < _types.size(); ++i)
+        {
+            GetVersions(chunk, i)[row] = ComponentVersion();
+        }
+    }
+
+    void Archetype::DestructRow(uint32_t chunkIndex, uint32_t row)
+    {
+        for (uint32_t i = 0; i < _types.size(); ++i)
+        {
+            _types[i]->destruct(GetComponent(chunkIndex, row, i));
+        }
+    }
+
+    Entity::Id Archetype::Free(uint32_t chunkIndex, uint32_t row)
+    {
+        const uint32_t lastChunkIndex = GetChunkCount() - 1;
+        ArchetypeChunk& lastChunk = _chunks[lastChunkIndex];
+        const uint32_t lastRow = lastChunk.count - 1;
+
+        Entity::Id moved = Entity::INVALID;
+        if (chunkIndex != lastChunkIndex || row != lastRow)
+        {
+            for (uint32_t i = 0; i < _types.size(); ++i)
+            {
+                _types[i]->relocate(GetComponent(chunkIndex, row, i), GetComponent(lastChunkIndex, lastRow, i));
+                const ComponentVersion& version = GetVersions(lastChunk, i)[lastRow];
+                GetVersion(chunkIndex, row, i) = version;
+                MarkChanged(chunkIndex, i, version.changed);
+            }
+
+            moved = GetEntities(lastChunk)[lastRow];
+            GetEntities(_chunks[chunkIndex])[row] = moved;
+        }
+
+        if (--lastChunk.count == 0)
+        {
+            free(_spareChunk);
+            _spareChunk = lastChunk.data;
+            _chunks.pop_back();
+        }
+
+        return moved;
+    }
+
+    void Archetype::MarkChanged(uint32_t chunkIndex, uint32_t typeIndex, uint32_t version)
+    {
+        std::atomic<uint32_t>& chunkVersion = _chunks[chunkIndex].versions[typeIndex];
+        uint32_t current = chunkVersion.load(memory_order_relaxed);
+        while (current < version && !chunkVersion.compare_exchange_weak(current, version, memory_order_relaxed))
+        {
+        }
     }
 
-    BaseComponent* ComponentStorage::Get(std::size_t index)
+    void Archetype::Clear()
     {
-        assert(index < size());
-        return _data[index].Get();
+        for (uint32_t i = 0; i < GetChunkCount(); ++i)
+        {
+            for (uint32_t row = 0; row < _chunks[i].count; ++row)
+            {
+                DestructRow(i, row);
+            }
+
+            if (_spareChunk)
+            {
+                free(_chunks[i].data);
+            }
+            else
+            {
+                _spareChunk = _chunks[i].data;
+            }
+        }
+
+        _chunks.clear();
     }
 
-    void ComponentStorage::Destroy(std::size_t index)
+    Archetype* Archetype::GetAddEdge(uint32_t family) const
     {
-        assert(index < size());
-        auto& element = _data[index];
-        element.Reset();
+        auto it = _addEdges.find(family);
+        return it != _addEdges.end() ? it->second : nullptr;
     }
 
-    void ComponentStorage::Set(uint32_t index, const IntrusivePtr<BaseComponent>& component)
+    Archetype* Archetype::GetRemoveEdge(uint32_t family) const
     {
-        _data[index] = component;
+        auto it = _removeEdges.find(family);
+        return it != _removeEdges.end() ? it->second : nullptr;
     }
 
     // Entity
     const Entity::Id Entity::INVALID;
 
-    void Entity::SetName(const std::string& name)
+    void Entity::SetName(const Name& name)
     {
         ALIMER_ASSERT(IsValid());
         _manager->SetEntityName(_id, name);
     }
 
-    const std::string& Entity::GetName() const
+    Name Entity::GetName() const
     {
         ALIMER_ASSERT(IsValid());
         return _manager->GetEntityName(_id);
@@ -80,6 +422,7 @@ namespace Alimer
     // EntityManager
     EntityManager::EntityManager()
         : _indexCounter(0)
+        , _commands(new EntityCommandBuffer(*this))
     {
 
     }
@@ -91,21 +434,68 @@ namespace Alimer
 
     void EntityManager::Reset()
     {
+        _commands->Clear();
+
         //for (entity entity : all_entities())
         //{
         //    entity.destroy();
         //}
 
         _componentPools.clear();
+        _entityNames.Clear();
+        _archetypeList.clear();
+        _archetypes.clear();
+        _entityLocation.clear();
         _entityComponentMask.clear();
+        _blockComponentMask.clear();
+        for (auto& query : _queries)
+        {
+            query.second->_entities.Clear();
+        }
 
         _entityVersion.clear();
         _freeList.clear();
+        _reservedFree.store(0, memory_order_relaxed);
+        _reservedNew.store(0, memory_order_relaxed);
         _indexCounter = 0;
+        _baseStructureVersion = ++_structureVersion;
+    }
+
+    Entity::Id EntityManager::ReserveId()
+    {
+        // The free list is not modified while ids are being reserved, slots are handed out from its back.
+        const uint32_t slot = _reservedFree.fetch_add(1, memory_order_relaxed);
+        if (slot < _freeList.size())
+        {
+            const uint32_t index = _freeList[_freeList.size() - 1 - slot];
+            return Entity::Id(index, _entityVersion[index]);
+        }
+
+        return Entity::Id(_indexCounter + _reservedNew.fetch_add(1, memory_order_relaxed), 1);
+    }
+
+    void EntityManager::FlushReserved()
+    {
+        if (_reservedFree.load(memory_order_relaxed) == 0 && _reservedNew.load(memory_order_relaxed) == 0)
+            return;
+
+        const size_t reservedFree = std::min<size_t>(_reservedFree.exchange(0, memory_order_acquire), _freeList.size());
+        _freeList.resize(_freeList.size() - reservedFree);
+
+        const uint32_t reservedNew = _reservedNew.exchange(0, memory_order_acquire);
+        if (reservedNew)
+        {
+            const uint32_t first = _indexCounter;
+            _indexCounter += reservedNew;
+            AccomodateEntity(_indexCounter - 1);
+            std::fill(_entityVersion.begin() + first, _entityVersion.begin() + _indexCounter, 1u);
+        }
     }
 
     Entity EntityManager::Create()
     {
+        FlushReserved();
+
         std::uint32_t index, version;
         if (_freeList.empty())
         {
@@ -126,31 +516,154 @@ namespace Alimer
         return entity;
     }
 
+    void EntityManager::CreateMany(uint32_t count, Entity::Id* ids)
+    {
+        FlushReserved();
+
+        // Reuse free slots first, most recently freed first like Create.
+        const uint32_t reused = std::min(count, static_cast<uint32_t>(_freeList.size()));
+        for (uint32_t i = 0; i < reused; ++i)
+        {
+            const uint32_t index = _freeList[_freeList.size() - 1 - i];
+            ids[i] = Entity::Id(index, _entityVersion[index]);
+        }
+        _freeList.resize(_freeList.size() - reused);
+
+        const uint32_t fresh = count - reused;
+        if (fresh)
+        {
+            const uint32_t first = _indexCounter;
+            _indexCounter += fresh;
+            AccomodateEntity(_indexCounter - 1);
+            std::fill(_entityVersion.begin() + first, _entityVersion.begin() + _indexCounter, 1u);
+            for (uint32_t i = 0; i < fresh; ++i)
+            {
+                ids[reused + i] = Entity::Id(first + i, 1);
+            }
+        }
+    }
+
+    void EntityManager::AssignMany(uint32_t count, const Entity::Id* ids, const ComponentPrototype* prototypes, uint32_t prototypeCount)
+    {
+        if (!count || !prototypeCount)
+            return;
+
+        std::vector<ComponentPrototype> sorted(prototypes, prototypes + prototypeCount);
+        std::sort(sorted.begin(), sorted.end(),
+            [](const ComponentPrototype& lhs, const ComponentPrototype& rhs) { return lhs.type->family < rhs.type->family; });
+
+        ComponentMask mask;
+        std::vector<const ComponentTypeInfo*> types;
+        types.reserve(prototypeCount);
+        for (const ComponentPrototype& prototype : sorted)
+        {
+            assert(prototype.type->copy && "Value component is not copy constructible");
+            mask.set(prototype.type->family);
+            types.push_back(prototype.type);
+        }
+
+        // Types are sorted by family, so the archetype type index is the prototype index.
+        Archetype* archetype = GetArchetype(mask, std::move(types));
+        const uint32_t version = GetVersion();
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const uint32_t index = ids[i].index();
+            assert(!_entityLocation[index].archetype && _entityComponentMask[index].none());
+
+            EntityLocation& location = _entityLocation[index];
+            archetype->Allocate(ids[i], location.chunk, location.row);
+            location.archetype = archetype;
+
+            for (uint32_t type = 0; type < prototypeCount; ++type)
+            {
+                const ComponentTypeInfo* info = sorted[type].type;
+                void* storage = archetype->GetComponent(location.chunk, location.row, type);
+                if (info->trivial)
+                {
+                    memcpy(storage, sorted[type].data, info->size);
+                }
+                else
+                {
+                    info->copy(storage, sorted[type].data);
+                }
+                archetype->MarkChanged(location.chunk, type, version);
+            }
+
+            _entityComponentMask[index] = mask;
+            _blockComponentMask[index / ENTITY_BLOCK_SIZE] |= mask;
+            for (const ComponentPrototype& prototype : sorted)
+            {
+                StampAdded(ids[i], prototype.type->family);
+                UpdateQueries(ids[i], prototype.type->family);
+            }
+        }
+    }
+
     void EntityManager::Destroy(Entity::Id id)
+    {
+        // Slots reserved from the free list must be claimed before it grows.
+        FlushReserved();
+
+        const uint32_t index = DestroyEntity(id);
+        UpdateBlockMask(index);
+    }
+
+    void EntityManager::DestroyMany(const Entity::Id* ids, uint32_t count)
+    {
+        FlushReserved();
+
+        _freeList.reserve(_freeList.size() + count);
+        std::vector<uint32_t> blocks;
+        blocks.reserve(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            blocks.push_back(DestroyEntity(ids[i]) / ENTITY_BLOCK_SIZE);
+        }
+
+        // Recompute each touched block mask once.
+        std::sort(blocks.begin(), blocks.end());
+        blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+        for (uint32_t block : blocks)
+        {
+            UpdateBlockMask(block * ENTITY_BLOCK_SIZE);
+        }
+    }
+
+    uint32_t EntityManager::DestroyEntity(Entity::Id id)
     {
         AssertValid(id);
-        
+
         std::uint32_t index = id.index();
-        auto mask = _entityComponentMask[index];
-        for (size_t i = 0; i < _componentPools.size(); ++i)
-        {
-            if (mask.test(i))
+        // Only visit the families the entity owns.
+        _entityComponentMask[index].ForEachSetBit([this, index](uint32_t family) {
+            MarkStructureChanged(family);
+
+            if (family < _componentPools.size() && _componentPools[family])
+            {
+                _componentPools[family]->Destroy(index);
+            }
+
+            if (family < _familyQueries.size())
             {
-                auto& pool = _componentPools[i];
-                if (pool)
+                for (EntityQuery* query : _familyQueries[family])
                 {
-                    BaseComponent* component = pool->Get(index);
-                    Remove(id, *component);
+                    if (query->_entities.Contains(index))
+                        query->_entities.Erase(index);
                 }
             }
-        }
+        });
+
+        // Value components are destroyed together with their archetype row.
+        ReleaseEntityRow(id);
 
         //OnEntityDestroyed(Get(id));
         _entityComponentMask[index].reset();
         _entityVersion[index]++;
         _freeList.push_back(index);
         // Remove name
-        _entityNames[id.id()].clear();
+        _entityNames.Remove(index);
+        return index;
     }
 
     Entity EntityManager::Get(Entity::Id id)
@@ -167,12 +680,19 @@ namespace Alimer
         // Placement new into the component pool.
         auto& pool = AccomodateComponent(family);
 
-        pool.Set(id.index(), component);
+        pool.Set(id, component);
         // Set the bit for this component.
         _entityComponentMask[id.index()].set(family);
+        _blockComponentMask[id.index() / ENTITY_BLOCK_SIZE].set(family);
+        UpdateQueries(id, family);
 
-        // Create and return handle.
-        //component->_entity = Get(id);
+        // Create and return handle. Shared components have no single owner.
+        BaseComponent* stored = pool.Get(id.index());
+        if (!stored->_shared)
+        {
+            stored->_entity = Get(id);
+        }
+        StampAdded(id, family);
         //component->OnEntitySet();
         //OnComponentAdded(Get(id), handle);
         return component;
@@ -188,12 +708,25 @@ namespace Alimer
         AssertValid(id);
         const std::uint32_t index = id.index();
 
+        const EntityLocation& location = _entityLocation[index];
+        if (location.archetype && location.archetype->GetTypeIndex(family) != Archetype::NPOS)
+        {
+            RemoveValueComponent(id, family);
+            return;
+        }
+
+        // Removing a component the entity does not have is a no-op.
+        if (!_entityComponentMask[index].test(family))
+            return;
+
         // Find the pool for this component family.
         auto& pool = _componentPools[family];
         BaseComponent* handle = pool->Get(id.index());
         //OnComponentRemoved(Get(id), handle);
         // Remove component bit.
         _entityComponentMask[id.index()].reset(family);
+        UpdateBlockMask(index);
+        UpdateQueries(id, family);
 
         // Call destructor.
         pool->Destroy(index);
@@ -208,40 +741,679 @@ namespace Alimer
     {
         AssertValid(id);
 
-        // We don't bother checking the component mask, as we return a nullptr anyway.
-        if (family >= _componentPools.size())
+        // Value components have no pool, the mask is authoritative for both storages.
+        return _entityComponentMask[id.index()].test(family);
+    }
+
+    FrameVector<BaseComponent*> EntityManager::GetAllComponents(Entity::Id id, FrameAllocator& allocator) const
+    {
+        FrameVector<BaseComponent*> components{ FrameStlAllocator<BaseComponent*>(&allocator) };
+        component_mask(id).ForEachSetBit([this, id, &components](uint32_t family) {
+            if (family < _componentPools.size() && _componentPools[family])
+            {
+                components.push_back(_componentPools[family]->Get(id.index()));
+            }
+        });
+        return components;
+    }
+
+    void EntityManager::MarkChanged(Entity::Id id, uint32_t family)
+    {
+        AssertValid(id);
+        assert(HasComponent(id, family));
+
+        const uint32_t version = GetVersion();
+        const EntityLocation& location = _entityLocation[id.index()];
+        const uint32_t typeIndex = location.archetype ? location.archetype->GetTypeIndex(family) : Archetype::NPOS;
+        if (typeIndex != Archetype::NPOS)
         {
-            return false;
+            location.archetype->GetVersion(location.chunk, location.row, typeIndex).changed = version;
+            location.archetype->MarkChanged(location.chunk, typeIndex, version);
+            return;
         }
-        auto& pool = _componentPools[family];
-        return !(!pool || !_entityComponentMask[id.index()][family]);
+
+        _componentPools[family]->GetVersion(id.index())->changed = version;
+    }
+
+    uint32_t EntityManager::GetAddedVersion(Entity::Id id, uint32_t family) const
+    {
+        const ComponentVersion* version = GetComponentVersion(id, family);
+        return version ? version->added : 0;
+    }
+
+    uint32_t EntityManager::GetChangedVersion(Entity::Id id, uint32_t family) const
+    {
+        const ComponentVersion* version = GetComponentVersion(id, family);
+        return version ? version->changed : 0;
+    }
+
+    void EntityManager::StampAdded(Entity::Id id, uint32_t family)
+    {
+        ComponentVersion* versions = GetComponentVersion(id, family);
+        assert(versions);
+
+        const uint32_t version = GetVersion();
+        versions->added = version;
+        versions->changed = version;
+    }
+
+    ComponentVersion* EntityManager::GetComponentVersion(Entity::Id id, uint32_t family) const
+    {
+        const uint32_t index = id.index();
+        if (index >= _entityLocation.size())
+            return nullptr;
+
+        const EntityLocation& location = _entityLocation[index];
+        const uint32_t typeIndex = location.archetype ? location.archetype->GetTypeIndex(family) : Archetype::NPOS;
+        if (typeIndex != Archetype::NPOS)
+            return &location.archetype->GetVersion(location.chunk, location.row, typeIndex);
+
+        if (family >= _componentPools.size() || !_componentPools[family])
+            return nullptr;
+
+        return _componentPools[family]->GetVersion(index);
+    }
+
+    uint32_t EntityManager::GetStructureVersion(uint32_t family) const
+    {
+        const uint32_t version = family < _familyStructureVersions.size() ? _familyStructureVersions[family] : 0;
+        return std::max(version, _baseStructureVersion);
+    }
+
+    void EntityManager::MarkStructureChanged(uint32_t family)
+    {
+        if (family >= _familyStructureVersions.size())
+        {
+            _familyStructureVersions.resize(family + 1);
+        }
+
+        _familyStructureVersions[family] = ++_structureVersion;
+    }
+
+    void EntityManager::SetEntityName(Entity::Id id, const Name& name)
+    {
+        AssertValid(id);
+        _entityNames.Set(id, name);
+    }
+
+    Name EntityManager::GetEntityName(Entity::Id id) const
+    {
+        AssertValid(id);
+        return _entityNames.Get(id.index());
+    }
+
+    Entity EntityManager::FindEntity(const Name& name)
+    {
+        const Entity::Id id = _entityNames.Find(name);
+        return id != Entity::INVALID && IsValid(id) ? Entity(this, id) : Entity();
+    }
+
+    void EntityManager::UpdateBlockMask(uint32_t index)
+    {
+        const uint32_t block = index / ENTITY_BLOCK_SIZE;
+        const size_t begin = size_t(block) * ENTITY_BLOCK_SIZE;
+        const size_t end = std::min(begin + ENTITY_BLOCK_SIZE, _entityComponentMask.size());
+
+        ComponentMask mask;
+        for (size_t i = begin; i < end; ++i)
+        {
+            mask |= _entityComponentMask[i];
+        }
+
+        _blockComponentMask[block] = mask;
     }
 
-    std::vector<BaseComponent*> EntityManager::GetAllComponents(Entity::Id id) const
+    void EntityManager::SaveSnapshot(EntitySnapshot& snapshot, const EntitySnapshot* base)
     {
-        std::vector<BaseComponent*> components;
-        auto mask = component_mask(id);
-        for (size_t i = 0; i < _componentPools.size(); ++i)
+        FlushReserved();
+        snapshot.Clear();
+
+        // Nothing is shared with a snapshot taken before the last restore or reset.
+        if (base && (base->IsEmpty() || _baseStructureVersion > base->_structureVersion))
+            base = nullptr;
+
+        snapshot._indexCounter = _indexCounter;
+        snapshot._entityVersions.assign(_entityVersion.begin(), _entityVersion.begin() + _indexCounter);
+        snapshot._freeList = _freeList;
+
+        // Value components per chunk. Chunks keep the base copy of their entity ids if none of the archetype families
+        // moved since the base or the ids are equal, and then the base copy of every array not changed since.
+        size_t baseIndex = 0;
+        for (uint32_t i = 0; i < _archetypeList.size(); ++i)
         {
-            if (mask.test(i))
+            Archetype* archetype = _archetypeList[i];
+            if (!archetype->GetSize())
+                continue;
+
+            const EntitySnapshot::ArchetypeCopy* previous = nullptr;
+            if (base)
+            {
+                while (baseIndex < base->_archetypes.size() && base->_archetypes[baseIndex].index < i)
+                    ++baseIndex;
+                if (baseIndex < base->_archetypes.size() && base->_archetypes[baseIndex].index == i)
+                    previous = &base->_archetypes[baseIndex];
+            }
+
+            const std::vector<const ComponentTypeInfo*>& types = archetype->GetTypes();
+            bool rowsMoved = false;
+            for (const ComponentTypeInfo* type : types)
             {
-                auto& pool = _componentPools[i];
-                if (pool)
+                if (previous && GetStructureVersion(type->family) > base->_structureVersion)
+                    rowsMoved = true;
+            }
+
+            snapshot._archetypes.emplace_back();
+            EntitySnapshot::ArchetypeCopy& copy = snapshot._archetypes.back();
+            copy.index = i;
+            copy.chunks.resize(archetype->GetChunkCount());
+            for (uint32_t chunkIndex = 0; chunkIndex < archetype->GetChunkCount(); ++chunkIndex)
+            {
+                const ArchetypeChunk& chunk = archetype->GetChunk(chunkIndex);
+                const Entity::Id* entities = archetype->GetEntities(chunk);
+                const EntitySnapshot::ChunkCopy* previousChunk = previous && chunkIndex < previous->chunks.size() ?
+                    &previous->chunks[chunkIndex] : nullptr;
+                if (previousChunk && (previousChunk->entities->count != chunk.count ||
+                    (rowsMoved && memcmp(previousChunk->entities->data, entities, chunk.count * sizeof(Entity::Id)) != 0)))
                 {
-                    components.push_back(pool->Get(id.index()));
+                    previousChunk = nullptr;
+                }
+
+                EntitySnapshot::ChunkCopy& chunkCopy = copy.chunks[chunkIndex];
+                chunkCopy.entities = previousChunk ? previousChunk->entities :
+                    IntrusivePtr<EntitySnapshot::ArrayCopy>(new EntitySnapshot::ArrayCopy(nullptr, entities, chunk.count));
+                chunkCopy.components.reserve(types.size());
+                for (uint32_t typeIndex = 0; typeIndex < types.size(); ++typeIndex)
+                {
+                    if (previousChunk && archetype->GetChangeVersion(chunk, typeIndex) <= base->_version)
+                    {
+                        chunkCopy.components.push_back(previousChunk->components[typeIndex]);
+                    }
+                    else
+                    {
+                        chunkCopy.components.emplace_back(new EntitySnapshot::ArrayCopy(types[typeIndex],
+                            archetype->GetComponentArray(chunk, typeIndex), chunk.count));
+                    }
                 }
             }
         }
-        return components;
+
+        // Pooled components per family in dense order, as detached copies. Shared components are never modified in place
+        // and are kept by reference. A family whose structure did not move and that has no changes since the base is
+        // shared whole, otherwise positions holding the same entity as in the base keep unchanged copies.
+        baseIndex = 0;
+        for (uint32_t family = 0; family < _componentPools.size(); ++family)
+        {
+            const auto& pool = _componentPools[family];
+            if (!pool || !pool->size())
+                continue;
+
+            const EntitySnapshot::PoolCopy* previous = nullptr;
+            if (base)
+            {
+                while (baseIndex < base->_pools.size() && base->_pools[baseIndex]->family < family)
+                    ++baseIndex;
+                if (baseIndex < base->_pools.size() && base->_pools[baseIndex]->family == family)
+                    previous = base->_pools[baseIndex].Get();
+            }
+
+            const size_t count = pool->size();
+            const bool moved = !previous || GetStructureVersion(family) > base->_structureVersion;
+            if (!moved)
+            {
+                size_t position = 0;
+                while (position < count && pool->GetVersionAt(position).changed <= base->_version)
+                    ++position;
+
+                if (position == count)
+                {
+                    snapshot._pools.push_back(base->_pools[baseIndex]);
+                    continue;
+                }
+            }
+
+            IntrusivePtr<EntitySnapshot::PoolCopy> copy(new EntitySnapshot::PoolCopy());
+            copy->family = family;
+            if (moved)
+            {
+                std::vector<Entity::Id> entities(count);
+                for (size_t position = 0; position < count; ++position)
+                {
+                    entities[position] = pool->GetEntityAt(position);
+                }
+                copy->entities = IntrusivePtr<EntitySnapshot::ArrayCopy>(
+                    new EntitySnapshot::ArrayCopy(nullptr, entities.data(), static_cast<uint32_t>(count)));
+            }
+            else
+            {
+                copy->entities = previous->entities;
+            }
+            copy->components.reserve(count);
+
+            const Entity::Id* previousEntities = previous ? reinterpret_cast<const Entity::Id*>(previous->entities->data) : nullptr;
+            const size_t previousCount = previous ? previous->entities->count : 0;
+            for (size_t position = 0; position < count; ++position)
+            {
+                if (position < previousCount && previousEntities[position] == pool->GetEntityAt(position) &&
+                    pool->GetVersionAt(position).changed <= base->_version)
+                {
+                    copy->components.push_back(previous->components[position]);
+                }
+                else
+                {
+                    copy->components.push_back(CopyForSnapshot(pool->GetHandleAt(position)));
+                }
+            }
+            snapshot._pools.push_back(std::move(copy));
+        }
+
+        _entityNames.ForEach([&snapshot](Entity::Id id, const Name& name) {
+            snapshot._names.emplace_back(id, name);
+        });
+
+        // Changes from here on are stamped with a newer version than the snapshot.
+        snapshot._structureVersion = _structureVersion;
+        snapshot._version = GetVersion();
+        IncrementVersion();
     }
 
-    void EntityManager::SetEntityName(Entity::Id id, const std::string& name)
+    ComponentHandle EntityManager::CopyForSnapshot(const ComponentHandle& component)
     {
-        _entityNames[id.id()] = name;
+        if (component->_shared)
+            return component;
+
+        ComponentHandle copy = component->Clone();
+        if (!copy)
+        {
+            assert(false && "Pooled component is not copy constructible and can not be rolled back");
+            return component;
+        }
+
+        return copy;
     }
 
-    const std::string& EntityManager::GetEntityName(Entity::Id id)
+    void EntityManager::RestoreSnapshot(EntitySnapshot& snapshot)
     {
-        return _entityNames[id.id()];
+        assert(!snapshot.IsEmpty());
+        FlushReserved();
+
+        for (Archetype* archetype : _archetypeList)
+        {
+            archetype->Clear();
+        }
+
+        for (auto& pool : _componentPools)
+        {
+            if (pool)
+                pool->Clear();
+        }
+
+        const uint32_t indexCounter = snapshot._indexCounter;
+        _indexCounter = indexCounter;
+        _entityVersion = snapshot._entityVersions;
+        _freeList = snapshot._freeList;
+
+        _entityComponentMask.clear();
+        _entityComponentMask.resize(indexCounter);
+        _entityLocation.clear();
+        _entityLocation.resize(indexCounter);
+        _blockComponentMask.clear();
+        _blockComponentMask.resize((indexCounter + ENTITY_BLOCK_SIZE - 1) / ENTITY_BLOCK_SIZE);
+
+        const uint32_t version = IncrementVersion();
+        for (const EntitySnapshot::ArchetypeCopy& copy : snapshot._archetypes)
+        {
+            assert(copy.index < _archetypeList.size() && "Snapshot was taken before the entity manager was reset");
+
+            Archetype* archetype = _archetypeList[copy.index];
+            const std::vector<const ComponentTypeInfo*>& types = archetype->GetTypes();
+            for (const EntitySnapshot::ChunkCopy& chunkCopy : copy.chunks)
+            {
+                // Rows fill chunks in the same order they were saved.
+                const uint32_t count = chunkCopy.entities->count;
+                const Entity::Id* entities = reinterpret_cast<const Entity::Id*>(chunkCopy.entities->data);
+                uint32_t chunkIndex = 0;
+                uint32_t row = 0;
+                for (uint32_t j = 0; j < count; ++j)
+                {
+                    const Entity::Id id = entities[j];
+                    archetype->Allocate(id, chunkIndex, row);
+
+                    EntityLocation& location = _entityLocation[id.index()];
+                    location.archetype = archetype;
+                    location.chunk = chunkIndex;
+                    location.row = row;
+                    _entityComponentMask[id.index()] = archetype->GetMask();
+                }
+
+                const ArchetypeChunk& chunk = archetype->GetChunk(chunkIndex);
+                for (uint32_t typeIndex = 0; typeIndex < types.size(); ++typeIndex)
+                {
+                    const ComponentTypeInfo* type = types[typeIndex];
+                    const EntitySnapshot::ArrayCopy& components = *chunkCopy.components[typeIndex];
+                    assert(components.type == type && components.count == count);
+
+                    uint8_t* target = static_cast<uint8_t*>(archetype->GetComponentArray(chunk, typeIndex));
+                    if (type->trivial)
+                    {
+                        memcpy(target, components.data, count * type->size);
+                    }
+                    else
+                    {
+                        for (uint32_t j = 0; j < count; ++j)
+                        {
+                            type->copy(target + j * type->size, components.data + j * type->size);
+                        }
+                    }
+
+                    archetype->MarkChanged(chunkIndex, typeIndex, version);
+                }
+            }
+        }
+
+        for (const IntrusivePtr<EntitySnapshot::PoolCopy>& copy : snapshot._pools)
+        {
+            ComponentStorage& pool = AccomodateComponent(copy->family);
+            const uint32_t count = copy->entities->count;
+            const Entity::Id* entities = reinterpret_cast<const Entity::Id*>(copy->entities->data);
+            pool.Reserve(count);
+            for (uint32_t j = 0; j < count; ++j)
+            {
+                // Restore a copy, the snapshot must stay intact for later restores.
+                const Entity::Id id = entities[j];
+                ComponentHandle component = CopyForSnapshot(copy->components[j]);
+                if (!component->_shared)
+                {
+                    component->_entity = Entity(this, id);
+                }
+                pool.Set(id, component);
+                _entityComponentMask[id.index()].set(copy->family);
+            }
+        }
+
+        // Names of entities destroyed since the snapshot come back, names given since are dropped.
+        _entityNames.Clear();
+        for (const auto& name : snapshot._names)
+        {
+            _entityNames.Set(name.first, name.second);
+        }
+
+        // Masks are final: every restored component counts as added, then rebuild block masks and queries.
+        for (uint32_t index = 0; index < indexCounter; ++index)
+        {
+            const ComponentMask& mask = _entityComponentMask[index];
+            const Entity::Id id(index, _entityVersion[index]);
+            mask.ForEachSetBit([this, id](uint32_t family) { StampAdded(id, family); });
+            _blockComponentMask[index / ENTITY_BLOCK_SIZE] |= mask;
+        }
+
+        for (auto& query : _queries)
+        {
+            query.second->_entities.Clear();
+            PopulateQuery(*query.second);
+        }
+
+        _baseStructureVersion = ++_structureVersion;
+
+        // Current state equals the snapshot again, which can serve as base of the next SaveSnapshot.
+        snapshot._structureVersion = _structureVersion;
+        snapshot._version = version;
+        IncrementVersion();
+    }
+
+    EntityQuery& EntityManager::GetQuery(const ComponentMask& mask)
+    {
+        assert(mask.any() && "Query requires at least one component");
+
+        auto it = _queries.find(mask);
+        if (it != _queries.end())
+            return *it->second;
+
+        std::unique_ptr<EntityQuery> query(new EntityQuery(this, mask));
+        mask.ForEachSetBit([this, &query](uint32_t family) {
+            if (_familyQueries.size() <= family)
+            {
+                _familyQueries.resize(family + 1);
+            }
+            _familyQueries[family].push_back(query.get());
+        });
+
+        // Initial matches, later kept up to date by UpdateQueries.
+        PopulateQuery(*query);
+
+        EntityQuery& result = *query;
+        _queries.emplace(mask, std::move(query));
+        return result;
+    }
+
+    void EntityManager::PopulateQuery(EntityQuery& query)
+    {
+        const ComponentMask& mask = query._mask;
+        const uint32_t capacity = static_cast<uint32_t>(GetCapacity());
+        for (uint32_t index = 0; index < capacity; ++index)
+        {
+            if ((index % ENTITY_BLOCK_SIZE) == 0 && !_blockComponentMask[index / ENTITY_BLOCK_SIZE].Contains(mask))
+            {
+                index += ENTITY_BLOCK_SIZE - 1;
+                continue;
+            }
+
+            if (_entityComponentMask[index].Contains(mask))
+            {
+                query._entities.Insert(CreateId(index));
+            }
+        }
+    }
+
+    void EntityManager::UpdateQueries(Entity::Id id, uint32_t family)
+    {
+        MarkStructureChanged(family);
+
+        if (family >= _familyQueries.size())
+            return;
+
+        const uint32_t index = id.index();
+        const ComponentMask& mask = _entityComponentMask[index];
+        for (EntityQuery* query : _familyQueries[family])
+        {
+            if (mask.Contains(query->_mask))
+            {
+                query->_entities.Insert(id);
+            }
+            else if (query->_entities.Contains(index))
+            {
+                query->_entities.Erase(index);
+            }
+        }
+    }
+
+    void* EntityManager::AssignValueComponent(Entity::Id id, const ComponentTypeInfo* type)
+    {
+        AssertValid(id);
+        const uint32_t index = id.index();
+        EntityLocation& location = _entityLocation[index];
+        Archetype* source = location.archetype;
+
+        if (source)
+        {
+            const uint32_t typeIndex = source->GetTypeIndex(type->family);
+            if (typeIndex != Archetype::NPOS)
+            {
+                // Replace existing component in place.
+                void* storage = source->GetComponent(location.chunk, location.row, typeIndex);
+                type->destruct(storage);
+                StampAdded(id, type->family);
+                source->MarkChanged(location.chunk, typeIndex, GetVersion());
+                return storage;
+            }
+        }
+
+        Archetype* target = source ? source->GetAddEdge(type->family) : nullptr;
+        if (!target)
+        {
+            ComponentMask mask;
+            std::vector<const ComponentTypeInfo*> types;
+            if (source)
+            {
+                mask = source->GetMask();
+                types = source->GetTypes();
+            }
+
+            mask.set(type->family);
+            types.insert(std::upper_bound(types.begin(), types.end(), type,
+                [](const ComponentTypeInfo* lhs, const ComponentTypeInfo* rhs) { return lhs->family < rhs->family; }),
+                type);
+
+            target = GetArchetype(mask, std::move(types));
+            if (source)
+            {
+                source->SetAddEdge(type->family, target);
+                target->SetRemoveEdge(type->family, source);
+            }
+        }
+
+        MoveEntity(id, target);
+        _entityComponentMask[index].set(type->family);
+        _blockComponentMask[index / ENTITY_BLOCK_SIZE].set(type->family);
+        UpdateQueries(id, type->family);
+
+        const uint32_t typeIndex = target->GetTypeIndex(type->family);
+        StampAdded(id, type->family);
+        target->MarkChanged(location.chunk, typeIndex, GetVersion());
+        return target->GetComponent(location.chunk, location.row, typeIndex);
+    }
+
+    void EntityManager::RemoveValueComponent(Entity::Id id, uint32_t family)
+    {
+        const uint32_t index = id.index();
+        Archetype* source = _entityLocation[index].archetype;
+        assert(source && source->GetTypeIndex(family) != Archetype::NPOS);
+
+        _entityComponentMask[index].reset(family);
+        UpdateBlockMask(index);
+        UpdateQueries(id, family);
+        if (source->GetTypes().size() == 1)
+        {
+            ReleaseEntityRow(id);
+            return;
+        }
+
+        Archetype* target = source->GetRemoveEdge(family);
+        if (!target)
+        {
+            ComponentMask mask = source->GetMask();
+            mask.reset(family);
+
+            std::vector<const ComponentTypeInfo*> types;
+            types.reserve(source->GetTypes().size() - 1);
+            for (const ComponentTypeInfo* type : source->GetTypes())
+            {
+                if (type->family != family)
+                {
+                    types.push_back(type);
+                }
+            }
+
+            target = GetArchetype(mask, std::move(types));
+            source->SetRemoveEdge(family, target);
+            target->SetAddEdge(family, source);
+        }
+
+        MoveEntity(id, target);
+    }
+
+    void* EntityManager::GetValueComponent(Entity::Id id, uint32_t family) const
+    {
+        const EntityLocation& location = _entityLocation[id.index()];
+        if (!location.archetype)
+            return nullptr;
+
+        const uint32_t typeIndex = location.archetype->GetTypeIndex(family);
+        if (typeIndex == Archetype::NPOS)
+            return nullptr;
+
+        return location.archetype->GetComponent(location.chunk, location.row, typeIndex);
+    }
+
+    void EntityManager::MoveEntity(Entity::Id id, Archetype* target)
+    {
+        EntityLocation& location = _entityLocation[id.index()];
+        Archetype* source = location.archetype;
+
+        uint32_t chunk, row;
+        target->Allocate(id, chunk, row);
+
+        if (source)
+        {
+            // Relocate shared components, destroy the ones the target lacks.
+            const auto& types = source->GetTypes();
+            for (uint32_t i = 0; i < types.size(); ++i)
+            {
+                void* component = source->GetComponent(location.chunk, location.row, i);
+                const uint32_t targetIndex = target->GetTypeIndex(types[i]->family);
+                if (targetIndex != Archetype::NPOS)
+                {
+                    types[i]->relocate(target->GetComponent(chunk, row, targetIndex), component);
+                    const ComponentVersion& version = source->GetVersion(location.chunk, location.row, i);
+                    target->GetVersion(chunk, row, targetIndex) = version;
+                    target->MarkChanged(chunk, targetIndex, version.changed);
+                }
+                else
+                {
+                    types[i]->destruct(component);
+                }
+            }
+
+            Entity::Id moved = source->Free(location.chunk, location.row);
+            if (moved != Entity::INVALID)
+            {
+                _entityLocation[moved.index()] = location;
+            }
+
+            MarkRowsMoved(*source);
+        }
+
+        location.archetype = target;
+        location.chunk = chunk;
+        location.row = row;
+    }
+
+    void EntityManager::ReleaseEntityRow(Entity::Id id)
+    {
+        EntityLocation& location = _entityLocation[id.index()];
+        Archetype* archetype = location.archetype;
+        if (!archetype)
+            return;
+
+        archetype->DestructRow(location.chunk, location.row);
+        Entity::Id moved = archetype->Free(location.chunk, location.row);
+        if (moved != Entity::INVALID)
+        {
+            _entityLocation[moved.index()] = location;
+        }
+
+        MarkRowsMoved(*archetype);
+
+        location = EntityLocation();
+    }
+
+    void EntityManager::MarkRowsMoved(const Archetype& archetype)
+    {
+        // Component addresses of the archetype changed, cached pointers into its chunks are stale.
+        for (const ComponentTypeInfo* type : archetype.GetTypes())
+        {
+            MarkStructureChanged(type->family);
+        }
+    }
+
+    Archetype* EntityManager::GetArchetype(const ComponentMask& mask, std::vector<const ComponentTypeInfo*> types)
+    {
+        auto it = _archetypes.find(mask);
+        if (it != _archetypes.end())
+            return it->second.get();
+
+        Archetype* archetype = new Archetype(mask, std::move(types));
+        _archetypes.emplace(mask, std::unique_ptr<Archetype>(archetype));
+        _archetypeList.push_back(archetype);
+        return archetype;
     }
 }
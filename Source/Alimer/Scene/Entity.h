@@ -27,12 +27,13 @@
 // EntityX: https://github.com/alecthomas/entityx
 // Granite: https://github.com/Themaister/Granite
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <tuple>
 #include <new>
 #include <cstdlib>
 #include <algorithm>
-#include <bitset>
 #include <cassert>
 #include <iostream>
 #include <iterator>
@@ -47,67 +48,58 @@
 #include <functional>
 
 #include  "../Serialization/Serializable.h"
+#include  "../Base/FrameAllocator.h"
 #include  "../Base/IntrusivePtr.h"
+#include  "../Base/Name.h"
+#include  "../Core/JobSystem.h"
+#include  "../Scene/ComponentMask.h"
 
 namespace Alimer
 {
     struct ComponentIDMapping
     {
     public:
+        /// Return family id of T, assigned on first use. Safe to call from any thread.
         template <typename T>
         static uint32_t GetId()
         {
-            static uint32_t id = ids++;
+            static const uint32_t id = ids.fetch_add(1, std::memory_order_relaxed);
             return id;
         }
 
     private:
-        static uint32_t ids;
+        static std::atomic<uint32_t> ids;
     };
 
     class BaseComponent;
-    class ComponentStorage
-    {
-    public:
-        ComponentStorage(std::size_t size = 100);
-
-        inline std::size_t size() const
-        {
-            return _data.size();
-        }
-        inline std::size_t capacity() const
-        {
-            return _data.capacity();
-        }
-        /// Ensure at least n elements will fit in the pool.
-        void Expand(std::size_t size);
-        void Reserve(std::size_t size);
-        BaseComponent* Get(std::size_t index);
-
-        template <typename T>
-        T* Get(std::size_t index)
-        {
-            static_assert(std::is_base_of<BaseComponent, T>::value, "Invalid component type.");
+    class EntityManager;
+    class EntityCommandBuffer;
+    class EntitySnapshot;
 
-            return static_cast<T*>(Get(index));
-        }
-
-        void Destroy(std::size_t index);
+    /// Components not derived from BaseComponent are stored by value in archetype chunks.
+    template <typename T>
+    struct IsValueComponent : std::integral_constant<bool, !std::is_base_of<BaseComponent, T>::value>
+    {
+    };
 
-        template <typename T, typename... Args>
-        IntrusivePtr<T> Set(uint32_t index, Args&&... args)
-        {
-            auto element = MakeHandle<T>(std::forward<Args>(args)...);
-            _data[index] = element;
-            return element;
-        }
+    template <typename... Components>
+    struct AllValueComponents;
 
-        void Set(uint32_t index, const IntrusivePtr<BaseComponent>& component);
+    template <>
+    struct AllValueComponents<> : std::true_type
+    {
+    };
 
-    private:
-        std::vector<IntrusivePtr<BaseComponent>> _data;
+    template <typename T, typename... Components>
+    struct AllValueComponents<T, Components...>
+        : std::integral_constant<bool, IsValueComponent<T>::value && AllValueComponents<Components...>::value>
+    {
     };
 
+    /// Reference returned when assigning a component: pointer into chunk storage for value components, handle otherwise.
+    template <typename T>
+    using ComponentRef = typename std::conditional<IsValueComponent<T>::value, T*, IntrusivePtr<T>>::type;
+
     /// 
     class ALIMER_API Entity final
     {
@@ -168,12 +160,14 @@ namespace Alimer
 
         Id GetId() const { return _id; }
 
-        void SetName(const std::string& name);
-        const std::string& GetName() const;
+        /// Set entity name, an empty name removes it.
+        void SetName(const Name& name);
+        /// Return entity name, empty if unnamed.
+        Name GetName() const;
 
         /// Assign component to entity.
         template <typename T, typename... Args>
-        IntrusivePtr<T> Assign(Args&&... args);
+        ComponentRef<T> Assign(Args&&... args);
 
         /// Assign component to entity.
         IntrusivePtr<BaseComponent> Assign(const IntrusivePtr<BaseComponent>& component);
@@ -192,9 +186,22 @@ namespace Alimer
         /// Checks if entity has given component
         bool HasComponent(const BaseComponent& component) const;
 
+        /// Return component, or null. A shared component must only be read through it, modify it with Write.
         template <typename T>
         T* GetComponent() const;
 
+        /// Return component for modification and mark it changed, copying it first when shared.
+        template <typename T>
+        T* Write() const;
+
+        /// Mark component as changed for Changed filters.
+        template <typename T>
+        void MarkChanged() const;
+
+        /// Advance structure version of component family T in the owning manager.
+        template <typename T>
+        void MarkStructureChanged() const;
+
     private:
         EntityManager* _manager = nullptr;
         Entity::Id _id = INVALID;
@@ -204,21 +211,40 @@ namespace Alimer
     class ALIMER_API BaseComponent : public IntrusivePtrEnabled<BaseComponent>
     {
         friend class EntityManager;
+        friend class Prefab;
 
     public:
         BaseComponent() = default;
         virtual ~BaseComponent() = default;
 
+        /// Return owning entity. Invalid for shared components.
         Entity GetEntity()
         {
             return _entity;
         }
 
+        /// Return whether the component is shared by several entities, as by Prefab instances, and must not be modified in place.
+        bool IsShared() const { return _shared; }
+
+        /// Return detached copy, not owned by an entity and not shared. Null when the component type is not copy constructible.
+        virtual IntrusivePtr<BaseComponent> Clone() const = 0;
+
     protected:
+        /// Copy-construct detached: the copy has its own reference count and no owner.
+        BaseComponent(const BaseComponent& rhs)
+            : IntrusivePtrEnabled<BaseComponent>()
+        {
+            ALIMER_UNUSED(rhs);
+        }
+
+        BaseComponent& operator=(const BaseComponent& rhs) = delete;
+
         virtual uint32_t GetFamily() const = 0;
 
         /// Owning entity
         Entity _entity;
+        /// Shared between entities, copied on write.
+        bool _shared = false;
     };
 
     template <typename T>
@@ -230,10 +256,28 @@ namespace Alimer
             return GetStaticFamilyId();
         }
 
+        IntrusivePtr<BaseComponent> CloneImpl(std::true_type) const
+        {
+            return IntrusivePtr<BaseComponent>(new T(static_cast<const T&>(*this)));
+        }
+
+        IntrusivePtr<BaseComponent> CloneImpl(std::false_type) const
+        {
+            return IntrusivePtr<BaseComponent>();
+        }
+
+    protected:
+        /// Copies are only made through Clone.
+        Component(const Component& rhs) = default;
+
     public:
         Component() = default;
-        Component(Component& rhs) = delete;
-        Component& operator=(Component& rhs) = delete;
+        Component& operator=(const Component& rhs) = delete;
+
+        IntrusivePtr<BaseComponent> Clone() const override
+        {
+            return CloneImpl(std::is_copy_constructible<T>());
+        }
 
         static uint32_t GetStaticFamilyId()
         {
@@ -243,12 +287,478 @@ namespace Alimer
 
     using ComponentHandle = IntrusivePtr<BaseComponent>;
 
+    /// Type information used to relocate, copy and destroy value components stored in archetype chunks.
+    struct ComponentTypeInfo
+    {
+        /// Component family id.
+        uint32_t family;
+        /// Size of the component in bytes.
+        uint32_t size;
+        /// Required alignment of the component.
+        uint32_t alignment;
+        /// Whether the component can be copied with memcpy.
+        bool trivial;
+        /// Move-construct into uninitialized destination and destroy the source.
+        void(*relocate)(void* dest, void* source);
+        /// Copy-construct into uninitialized destination, null for non copyable components.
+        void(*copy)(void* dest, const void* source);
+        /// Destroy component in place.
+        void(*destruct)(void* ptr);
+
+        template <typename T>
+        static const ComponentTypeInfo* Get()
+        {
+            static_assert(IsValueComponent<T>::value, "Only value components are stored in archetypes.");
+
+            static const ComponentTypeInfo info = {
+                ComponentIDMapping::GetId<T>(),
+                static_cast<uint32_t>(sizeof(T)),
+                static_cast<uint32_t>(alignof(T)),
+                std::is_trivially_copyable<T>::value,
+                [](void* dest, void* source) {
+                    T* src = static_cast<T*>(source);
+                    new (dest) T(std::move(*src));
+                    src->~T();
+                },
+                GetCopyFunction<T>(std::is_copy_constructible<T>()),
+                [](void* ptr) { static_cast<T*>(ptr)->~T(); }
+            };
+            return &info;
+        }
+
+    private:
+        template <typename T>
+        static void(*GetCopyFunction(std::true_type))(void*, const void*)
+        {
+            return [](void* dest, const void* source) { new (dest) T(*static_cast<const T*>(source)); };
+        }
+
+        template <typename T>
+        static void(*GetCopyFunction(std::false_type))(void*, const void*)
+        {
+            return nullptr;
+        }
+    };
+
+    /// Value component instance used as copy source by bulk assignment.
+    struct ComponentPrototype
+    {
+        const ComponentTypeInfo* type;
+        const void* data;
+    };
+
+    /// Number of entity slots summarized by one block mask, used to skip empty ranges during iteration.
+    static constexpr uint32_t ENTITY_BLOCK_SIZE = 64;
+
+    /// Size in bytes of a single archetype chunk.
+    static constexpr uint32_t ARCHETYPE_CHUNK_SIZE = 16 * 1024;
+
+    /// Change tracking versions of one component.
+    struct ComponentVersion
+    {
+        uint32_t added = 0;
+        uint32_t changed = 0;
+    };
+
+    /// Fixed size block holding entity ids followed by one packed array per component type, then one version array
+    /// per component type.
+    struct ArchetypeChunk
+    {
+        /// Number of live rows.
+        uint32_t count;
+        /// Chunk memory, ARCHETYPE_CHUNK_SIZE bytes.
+        uint8_t* data;
+        /// Highest change version of each component array.
+        std::unique_ptr<std::atomic<uint32_t>[]> versions;
+    };
+
+    /// Storage for all entities sharing the same set of value components.
+    /// Rows are kept dense: only the last chunk may be partially filled.
+    class ALIMER_API Archetype final
+    {
+    public:
+        /// Position for "not found."
+        static constexpr uint32_t NPOS = 0xffffffff;
+
+        /// Constructor. Types must be sorted by family.
+        Archetype(const ComponentMask& mask, std::vector<const ComponentTypeInfo*> types);
+
+        /// Destructor. Destroys all components still alive.
+        ~Archetype();
+
+        /// Return value component mask.
+        const ComponentMask& GetMask() const { return _mask; }
+        /// Return component types sorted by family.
+        const std::vector<const ComponentTypeInfo*>& GetTypes() const { return _types; }
+        /// Return maximum number of rows per chunk.
+        uint32_t GetChunkCapacity() const { return _chunkCapacity; }
+        /// Return number of chunks in use.
+        uint32_t GetChunkCount() const { return static_cast<uint32_t>(_chunks.size()); }
+        /// Return chunk by index.
+        ArchetypeChunk& GetChunk(uint32_t index) { return _chunks[index]; }
+        /// Return total number of entities.
+        size_t GetSize() const { return _chunks.empty() ? 0 : (_chunks.size() - 1) * _chunkCapacity + _chunks.back().count; }
+
+        /// Return index of component family inside this archetype, or NPOS.
+        uint32_t GetTypeIndex(uint32_t family) const
+        {
+            return family < _typeIndex.size() ? _typeIndex[family] : NPOS;
+        }
+
+        /// Return entity id array of a chunk.
+        Entity::Id* GetEntities(const ArchetypeChunk& chunk) const { return reinterpret_cast<Entity::Id*>(chunk.data); }
+
+        /// Return component array of a chunk by type index.
+        void* GetComponentArray(const ArchetypeChunk& chunk, uint32_t typeIndex) const { return chunk.data + _offsets[typeIndex]; }
+
+        /// Return component array of a chunk, template version.
+        template <typename T>
+        T* GetComponentArray(const ArchetypeChunk& chunk) const
+        {
+            return static_cast<T*>(GetComponentArray(chunk, GetTypeIndex(ComponentIDMapping::GetId<T>())));
+        }
+
+        /// Return component in row by type index.
+        void* GetComponent(uint32_t chunkIndex, uint32_t row, uint32_t typeIndex) const
+        {
+            return _chunks[chunkIndex].data + _offsets[typeIndex] + row * _types[typeIndex]->size;
+        }
+
+        /// Return per row version array of a chunk by type index.
+        ComponentVersion* GetVersions(const ArchetypeChunk& chunk, uint32_t typeIndex) const
+        {
+            return reinterpret_cast<ComponentVersion*>(chunk.data + _versionOffset) + typeIndex * _chunkCapacity;
+        }
+
+        /// Return versions of the component in row by type index.
+        ComponentVersion& GetVersion(uint32_t chunkIndex, uint32_t row, uint32_t typeIndex) const
+        {
+            return GetVersions(_chunks[chunkIndex], typeIndex)[row];
+        }
+
+        /// Return highest change version of a component array in a chunk.
+        uint32_t GetChangeVersion(const ArchetypeChunk& chunk, uint32_t typeIndex) const
+        {
+            return chunk.versions[typeIndex].load(std::memory_order_relaxed);
+        }
+
+        /// Raise change version of a component array in a chunk. Safe to call concurrently.
+        void MarkChanged(uint32_t chunkIndex, uint32_t typeIndex, uint32_t version);
+
+        /// Reserve a row at the end of the archetype. Components are left uninitialized, versions are cleared.
+        void Allocate(Entity::Id id, uint32_t& chunkIndex, uint32_t& row);
+        /// Destroy all components in a row.
+        void DestructRow(uint32_t chunkIndex, uint32_t row);
+        /// Release a row whose components were destroyed or relocated, filling the hole with the last row and its versions.
+        /// Returns id of the moved entity or Entity::INVALID.
+        Entity::Id Free(uint32_t chunkIndex, uint32_t row);
+        /// Destroy all rows and release their chunks.
+        void Clear();
+
+        /// Return cached archetype with the given family added, or null.
+        Archetype* GetAddEdge(uint32_t family) const;
+        /// Return cached archetype with the given family removed, or null.
+        Archetype* GetRemoveEdge(uint32_t family) const;
+        /// Cache archetype transition when adding a family.
+        void SetAddEdge(uint32_t family, Archetype* archetype) { _addEdges[family] = archetype; }
+        /// Cache archetype transition when removing a family.
+        void SetRemoveEdge(uint32_t family, Archetype* archetype) { _removeEdges[family] = archetype; }
+
+    private:
+        /// Value component mask.
+        ComponentMask _mask;
+        /// Component types sorted by family.
+        std::vector<const ComponentTypeInfo*> _types;
+        /// Byte offset of each component array inside a chunk.
+        std::vector<uint32_t> _offsets;
+        /// Byte offset of the version arrays inside a chunk.
+        uint32_t _versionOffset;
+        /// Type index by family, NPOS if absent.
+        std::vector<uint32_t> _typeIndex;
+        /// Rows per chunk.
+        uint32_t _chunkCapacity;
+        /// Chunks in use.
+        std::vector<ArchetypeChunk> _chunks;
+        /// Empty chunk kept around to avoid reallocation when oscillating at a chunk boundary.
+        uint8_t* _spareChunk = nullptr;
+        /// Archetype graph edges.
+        std::unordered_map<uint32_t, Archetype*> _addEdges;
+        std::unordered_map<uint32_t, Archetype*> _removeEdges;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(Archetype);
+    };
+
+    /// Query filter matching entities whose component T changed after the given version.
+    template <typename T>
+    struct Changed
+    {
+        explicit Changed(uint32_t version_) : version(version_) {}
+
+        uint32_t version;
+    };
+
+    /// Query filter matching entities whose component T was assigned after the given version.
+    template <typename T>
+    struct Added
+    {
+        explicit Added(uint32_t version_) : version(version_) {}
+
+        uint32_t version;
+    };
+
+    /// Component type tested by a Changed or Added filter.
+    template <typename Filter>
+    struct FilterComponent;
+
+    template <typename T>
+    struct FilterComponent<Changed<T>>
+    {
+        using Type = T;
+    };
+
+    template <typename T>
+    struct FilterComponent<Added<T>>
+    {
+        using Type = T;
+    };
+
+    /// Sparse set of entities. A paged sparse array maps entity index to a position in the densely packed id array,
+    /// so memory grows with the element count instead of the entity capacity.
+    class ALIMER_API EntitySparseSet
+    {
+    public:
+        /// Position for "not found."
+        static constexpr uint32_t NPOS = 0xffffffff;
+
+        /// Return number of entities.
+        inline std::size_t size() const
+        {
+            return _entities.size();
+        }
+
+        /// Return whether the entity index is present.
+        bool Contains(uint32_t index) const
+        {
+            return GetPosition(index) != NPOS;
+        }
+
+        /// Return dense position of entity index, or NPOS.
+        uint32_t GetPosition(uint32_t index) const
+        {
+            const uint32_t page = index / PAGE_SIZE;
+            if (page >= _sparse.size() || !_sparse[page])
+                return NPOS;
+
+            return _sparse[page][index % PAGE_SIZE];
+        }
+
+        /// Return entity at dense position.
+        Entity::Id GetEntityAt(std::size_t position) const { return _entities[position]; }
+
+        /// Ensure at least n entities will fit without reallocation.
+        void Reserve(std::size_t size) { _entities.reserve(size); }
+
+        /// Add entity and return its position. An entity already present keeps its position.
+        uint32_t Insert(Entity::Id id);
+
+        /// Remove entity index, moving the last entity into its position. Returns the vacated position, or NPOS if absent.
+        uint32_t Erase(uint32_t index);
+
+        /// Remove all entities.
+        void Clear();
+
+    private:
+        static constexpr uint32_t PAGE_SIZE = 1024;
+
+        /// Return sparse entry of entity index, allocating its page.
+        uint32_t& GetSparse(uint32_t index);
+
+        /// Dense positions by entity index, in pages allocated on demand.
+        std::vector<std::unique_ptr<uint32_t[]>> _sparse;
+        /// Packed entity ids.
+        std::vector<Entity::Id> _entities;
+    };
+
+    /// Entity names. Names are interned Name strings, so entities store a pointer sized handle and no string is copied.
+    /// Entities sharing a name are linked, so lookup by name is O(1).
+    class ALIMER_API EntityNameTable
+    {
+    public:
+        /// Set entity name, an empty name removes it.
+        void Set(Entity::Id id, const Name& name);
+        /// Remove name of entity index.
+        void Remove(uint32_t index);
+        /// Remove all names.
+        void Clear();
+
+        /// Return name of entity index, empty if unnamed.
+        Name Get(uint32_t index) const { return index < _slots.size() ? _slots[index].name : Name(); }
+        /// Return entity most recently given the name, or Entity::INVALID.
+        Entity::Id Find(const Name& name) const;
+
+        /// Invoke func(id) for every entity with the name.
+        template <typename Function>
+        void FindAll(const Name& name, Function&& func) const
+        {
+            auto it = _first.find(name);
+            if (it == _first.end())
+                return;
+
+            for (uint32_t index = it->second; index != NPOS; index = _slots[index].next)
+            {
+                func(_slots[index].id);
+            }
+        }
+
+        /// Invoke func(id, name) for every named entity.
+        template <typename Function>
+        void ForEach(Function&& func) const
+        {
+            for (const Slot& slot : _slots)
+            {
+                if (!slot.name.IsEmpty())
+                    func(slot.id, slot.name);
+            }
+        }
+
+        /// Return number of distinct names.
+        size_t GetNameCount() const { return _first.size(); }
+
+    private:
+        static constexpr uint32_t NPOS = 0xffffffff;
+
+        struct Slot
+        {
+            Name name;
+            uint32_t prev = NPOS;
+            uint32_t next = NPOS;
+            Entity::Id id;
+        };
+
+        /// First entity index in the list of entities using each name.
+        std::unordered_map<Name, uint32_t> _first;
+        /// Per entity index name and list links.
+        std::vector<Slot> _slots;
+    };
+
+    /// Sparse set of pooled components, packed in the same order as the owner entities.
+    class ComponentStorage
+    {
+    public:
+        /// Return number of stored components.
+        inline std::size_t size() const
+        {
+            return _dense.size();
+        }
+
+        /// Return whether the entity index owns a component.
+        bool Contains(uint32_t index) const
+        {
+            return _entities.Contains(index);
+        }
+
+        /// Ensure at least n components will fit without reallocation.
+        void Reserve(std::size_t size);
+        /// Return component of entity index, or null.
+        BaseComponent* Get(uint32_t index);
+
+        template <typename T>
+        T* Get(uint32_t index)
+        {
+            static_assert(std::is_base_of<BaseComponent, T>::value, "Invalid component type.");
+
+            return static_cast<T*>(Get(index));
+        }
+
+        /// Return versions of the component of entity index, or null.
+        ComponentVersion* GetVersion(uint32_t index)
+        {
+            const uint32_t position = _entities.GetPosition(index);
+            return position != EntitySparseSet::NPOS ? &_versions[position] : nullptr;
+        }
+
+        const ComponentVersion* GetVersion(uint32_t index) const
+        {
+            const uint32_t position = _entities.GetPosition(index);
+            return position != EntitySparseSet::NPOS ? &_versions[position] : nullptr;
+        }
+
+        /// Return component at dense position.
+        BaseComponent* GetAt(std::size_t position) { return _dense[position].Get(); }
+        /// Return component handle at dense position.
+        const IntrusivePtr<BaseComponent>& GetHandleAt(std::size_t position) const { return _dense[position]; }
+        /// Return owner entity at dense position.
+        Entity::Id GetEntityAt(std::size_t position) const { return _entities.GetEntityAt(position); }
+        /// Return versions of the component at dense position.
+        const ComponentVersion& GetVersionAt(std::size_t position) const { return _versions[position]; }
+
+        /// Remove component of entity index, moving the last component into its place. Does nothing if absent.
+        void Destroy(uint32_t index);
+
+        /// Set or replace component of entity. A replaced component keeps its versions.
+        void Set(Entity::Id id, const IntrusivePtr<BaseComponent>& component);
+
+        /// Remove all components.
+        void Clear();
+
+    private:
+        /// Owner entities.
+        EntitySparseSet _entities;
+        /// Packed components.
+        std::vector<IntrusivePtr<BaseComponent>> _dense;
+        /// Change tracking versions, packed like the components.
+        std::vector<ComponentVersion> _versions;
+    };
+
+    /// Persistent query over entities owning a set of components, obtained with EntityManager::GetQuery.
+    /// The matching entity list is kept up to date as components are assigned and removed, so iteration
+    /// never visits non-matching entities.
+    class ALIMER_API EntityQuery final
+    {
+    public:
+        /// Return required components.
+        const ComponentMask& GetMask() const { return _mask; }
+
+        /// Return number of matching entities.
+        std::size_t size() const { return _entities.size(); }
+
+        /// Return matching entity at position.
+        Entity::Id GetEntityAt(std::size_t position) const { return _entities.GetEntityAt(position); }
+
+        /// Return whether entity matches.
+        bool Contains(Entity::Id id) const
+        {
+            const uint32_t position = _entities.GetPosition(id.index());
+            return position != EntitySparseSet::NPOS && _entities.GetEntityAt(position) == id;
+        }
+
+        /// Invoke f(entity, components...) for every matching entity passing all filters. Components and filtered
+        /// types must be part of the query. Iterates backwards, so that removing components of the current entity
+        /// from inside f does not skip entities.
+        template <typename ... Components, typename Function, typename... Filters>
+        void Each(Function&& f, const Filters&... filters);
+
+    private:
+        friend class EntityManager;
+
+        EntityQuery(EntityManager* manager, const ComponentMask& mask)
+            : _manager(manager)
+            , _mask(mask)
+        {
+        }
+
+        EntityManager* _manager;
+        ComponentMask _mask;
+        EntitySparseSet _entities;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(EntityQuery);
+    };
+
     /// Manages the relationship between an Entity and its components
-    static const std::size_t MAX_COMPONENTS = 64;
     class ALIMER_API EntityManager final
     {
     public:
-        using ComponentMask = std::bitset<MAX_COMPONENTS>;
+        using ComponentMask = Alimer::ComponentMask;
 
         explicit EntityManager();
         ~EntityManager();
@@ -257,9 +767,38 @@ namespace Alimer
         /// Create a new entity.
         Entity Create();
 
+        /// Create count entities, writing their ids to the ids array. Entity storage grows once for the whole batch.
+        void CreateMany(uint32_t count, Entity::Id* ids);
+
+        /// Create count entities with copies of the given value components, allocated directly in their archetype.
+        template <typename C, typename... Components>
+        void CreateMany(uint32_t count, Entity::Id* ids, const C& prototype, const Components&... prototypes)
+        {
+            static_assert(AllValueComponents<C, Components...>::value, "Component templates must be value components.");
+
+            CreateMany(count, ids);
+            AssignValues<C, Components...>(count, ids, prototype, prototypes...);
+        }
+
+        /// Construct copies of value component prototypes for freshly created entities without components.
+        /// The archetype is resolved once, trivially copyable components are copied with memcpy.
+        void AssignMany(uint32_t count, const Entity::Id* ids, const ComponentPrototype* prototypes, uint32_t prototypeCount);
+
         /// Destroy an existing Entity and all its Components.
         void Destroy(Entity::Id id);
 
+        /// Destroy count entities, recomputing each touched block mask once.
+        void DestroyMany(const Entity::Id* ids, uint32_t count);
+
+        /// Reserve an entity id without touching entity storage. Thread safe; the entity becomes alive at the next FlushReserved.
+        Entity::Id ReserveId();
+
+        /// Make all reserved entity ids alive, growing entity storage once.
+        void FlushReserved();
+
+        /// Return command buffer for deferred structural changes, played back by the SystemManager once all systems have updated.
+        EntityCommandBuffer& GetCommandBuffer() { return *_commands; }
+
         /// Get entity by id.
         Entity Get(Entity::Id id);
 
@@ -280,14 +819,11 @@ namespace Alimer
             return id.index() < _entityVersion.size() && _entityVersion[id.index()] == id.version();
         }
 
+        /// Assign a component to an Entity. Value components are constructed in place inside archetype chunks.
         template <typename T, typename... Args>
-        IntrusivePtr<T> Assign(Entity::Id id, Args&&... args)
+        ComponentRef<T> Assign(Entity::Id id, Args&&... args)
         {
-            static_assert(std::is_base_of<BaseComponent, T>(), "T is not a component, cannot add T to entity");
-
-            IntrusivePtr<T> handle = MakeHandle<T>(std::forward<Args>(args)...);
-            Assign(id, handle);
-            return handle;
+            return AssignImpl<T>(IsValueComponent<T>(), id, std::forward<Args>(args)...);
         }
 
         IntrusivePtr<BaseComponent> Assign(Entity::Id id, const ComponentHandle& component);
@@ -312,30 +848,75 @@ namespace Alimer
         bool HasComponent(Entity::Id id, const  BaseComponent& component) const;
         bool HasComponent(Entity::Id id, uint32_t family) const;
 
+        /// Return component for modification and mark it changed. A shared pooled component is first replaced
+        /// by a private copy, which requires the component to be copy constructible.
         template <typename T>
-        T* GetComponent(Entity::Id id)
+        T* Write(Entity::Id id)
         {
-            AssertValid(id);
-            auto family = ComponentIDMapping::GetId<T>();
-            if (family >= _componentPools.size())
-            {
-                return nullptr;
-            }
-            auto& pool = _componentPools[family];
-            if (!pool || !_entityComponentMask[id.index()][family])
+            T* component = WriteImpl<T>(IsValueComponent<T>(), id);
+            if (component)
             {
-                return nullptr;
+                MarkChanged<T>(id);
             }
-            return pool->template Get<T>(id.index());
+            return component;
+        }
+
+        template <typename T>
+        T* GetComponent(Entity::Id id)
+        {
+            AssertValid(id);
+            return GetComponentImpl<T>(IsValueComponent<T>(), id);
         }
 
-        std::vector<BaseComponent*> GetAllComponents(Entity::Id id) const;
+        /// Return pooled components of an entity, in memory of the current frame.
+        FrameVector<BaseComponent*> GetAllComponents(Entity::Id id, FrameAllocator& allocator) const;
+
+        /// Return current change version, component changes are stamped with it.
+        uint32_t GetVersion() const { return _version.load(std::memory_order_relaxed); }
+
+        /// Advance change version and return the new value. Called by the SystemManager before each system update.
+        uint32_t IncrementVersion() { return _version.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+        /// Mark component as changed. Safe to call concurrently for different entities.
+        template <typename T>
+        void MarkChanged(Entity::Id id)
+        {
+            MarkChanged(id, ComponentIDMapping::GetId<T>());
+        }
+
+        void MarkChanged(Entity::Id id, uint32_t family);
+
+        /// Return version at which the component was last assigned.
+        uint32_t GetAddedVersion(Entity::Id id, uint32_t family) const;
+
+        /// Return version at which the component was last assigned or marked changed.
+        uint32_t GetChangedVersion(Entity::Id id, uint32_t family) const;
+
+        /// Return counter advanced whenever a component of the family is assigned or removed, value components of the
+        /// family move between chunk rows, the family structure is marked changed, or the manager is restored or reset.
+        /// Systems caching entity sets or component addresses rebuild when it moves.
+        uint32_t GetStructureVersion(uint32_t family) const;
+
+        template <typename T>
+        uint32_t GetStructureVersion() const
+        {
+            return GetStructureVersion(ComponentIDMapping::GetId<T>());
+        }
+
+        /// Advance structure version of the family, for relations between its components the manager does not track.
+        void MarkStructureChanged(uint32_t family);
 
         /// Set entity name
-        void SetEntityName(Entity::Id id, const std::string& name);
+        void SetEntityName(Entity::Id id, const Name& name);
 
         /// Get entity name
-        const std::string& GetEntityName(Entity::Id id);
+        Name GetEntityName(Entity::Id id) const;
+
+        /// Return entity most recently given the name, or an invalid entity.
+        Entity FindEntity(const Name& name);
+
+        /// Return interned entity names.
+        const EntityNameTable& GetEntityNames() const { return _entityNames; }
 
         /// An iterator over a view of the entities in an EntityManager.
         /// If All is true it will iterate over all valid entities and will ignore the entity mask.
@@ -369,8 +950,14 @@ namespace Alimer
             }
 
             void next() {
+                skip_empty_blocks();
                 while (i_ < capacity_ && !predicate()) {
                     ++i_;
+                    skip_empty_blocks();
+                }
+
+                if (i_ > capacity_) {
+                    i_ = static_cast<uint32_t>(capacity_);
                 }
 
                 if (i_ < capacity_) {
@@ -379,8 +966,16 @@ namespace Alimer
                 }
             }
 
+            /// Skip whole blocks where no entity can match.
+            inline void skip_empty_blocks() {
+                while (!All && (i_ % ENTITY_BLOCK_SIZE) == 0 && i_ < capacity_ &&
+                    !manager_->_blockComponentMask[i_ / ENTITY_BLOCK_SIZE].Contains(mask_)) {
+                    i_ += ENTITY_BLOCK_SIZE;
+                }
+            }
+
             inline bool predicate() {
-                return (All && valid_entity()) || (manager_->_entityComponentMask[i_] & mask_) == mask_;
+                return All ? valid_entity() : manager_->_entityComponentMask[i_].Contains(mask_);
             }
 
             inline bool valid_entity() {
@@ -421,7 +1016,7 @@ namespace Alimer
         private:
             friend class EntityManager;
 
-            explicit BaseView(EntityManager *manager) : manager_(manager) { mask_.set(); }
+            explicit BaseView(EntityManager *manager) : manager_(manager) {}
             BaseView(EntityManager *manager, ComponentMask mask) :
                 manager_(manager), mask_(mask) {}
 
@@ -432,18 +1027,88 @@ namespace Alimer
         template <bool All, typename ... Components>
         class TypedView : public BaseView<All> {
         public:
-            template <typename T> struct identity { typedef T type; };
+            /// Invoke f(entity, components...) for every matching entity passing all filters.
+            template <typename Function, typename... Filters>
+            void each(Function&& f, const Filters&... filters)
+            {
+                // Filtered types are required too, a pooled one is in no archetype and needs the pool walk.
+                EachImpl(f, AllValueComponents<Components..., typename FilterComponent<Filters>::Type...>(), filters...);
+            }
+
+        private:
+            friend class EntityManager;
 
-            void each(typename identity<std::function<void(Entity entity, Components&...)>>::type f)
+            /// Pooled components or filtered types present: walk the dense array of the smallest pool only. Iterates backwards, so that
+            /// removing the current entity components from inside f does not skip entities.
+            template <typename Function, typename... Filters>
+            void EachImpl(Function& f, std::false_type, const Filters&... filters)
             {
-                for (auto it : *this)
+                EntityManager* manager = this->manager_;
+                const ComponentStorage* pool = manager->template GetSmallestPool<Components..., typename FilterComponent<Filters>::Type...>();
+                if (!pool)
+                    return;
+
+                for (size_t i = pool->size(); i-- > 0;)
                 {
-                    f(it, *(it.template GetComponent<Components>())...);
+                    if (i >= pool->size())
+                        continue;
+
+                    const Entity::Id id = pool->GetEntityAt(i);
+                    if (!manager->_entityComponentMask[id.index()].Contains(this->mask_)
+                        || !manager->MatchesFilters(id, filters...))
+                    {
+                        continue;
+                    }
+
+                    f(Entity(manager, id), *manager->template GetComponentImpl<Components>(IsValueComponent<Components>(), id)...);
                 }
             }
 
-        private:
-            friend class EntityManager;
+            /// Value components only: walk matching archetypes chunk by chunk, skipping chunks rejected by the filters. Archetypes
+            /// created from inside f are not visited, chunks and rows are walked backwards like the pool walk.
+            template <typename Function, typename... Filters>
+            void EachImpl(Function& f, std::true_type, const Filters&... filters)
+            {
+                EntityManager* manager = this->manager_;
+                for (size_t a = 0, archetypeCount = manager->_archetypeList.size(); a < archetypeCount; ++a)
+                {
+                    Archetype& archetype = *manager->_archetypeList[a];
+                    if (!archetype.GetMask().Contains(this->mask_))
+                        continue;
+
+                    for (uint32_t i = archetype.GetChunkCount(); i-- > 0;)
+                    {
+                        if (i >= archetype.GetChunkCount() || !MatchesChunkFilters(archetype, archetype.GetChunk(i), filters...))
+                            continue;
+
+                        EachInChunk(manager, archetype, i, f, std::index_sequence_for<Components...>(), filters...);
+                    }
+                }
+            }
+
+            /// Walk the rows of one chunk backwards. Freeing a row moves the last row of the archetype into it, which was
+            /// already visited, so removals from inside f neither skip nor repeat entities.
+            template <typename Function, std::size_t... I, typename... Filters>
+            static void EachInChunk(EntityManager* manager, Archetype& archetype, uint32_t chunkIndex, Function& f, std::index_sequence<I...>, const Filters&... filters)
+            {
+                const std::array<uint32_t, sizeof...(Components)> typeIndices = { { archetype.GetTypeIndex(ComponentIDMapping::GetId<Components>())... } };
+                for (uint32_t row = archetype.GetChunk(chunkIndex).count; row-- > 0;)
+                {
+                    // The chunk vector may have been reallocated or shrunk by f.
+                    if (chunkIndex >= archetype.GetChunkCount())
+                        return;
+
+                    const ArchetypeChunk& chunk = archetype.GetChunk(chunkIndex);
+                    if (row >= chunk.count)
+                        continue;
+
+                    const Entity::Id id = archetype.GetEntities(chunk)[row];
+                    if (!manager->MatchesFilters(id, filters...))
+                        continue;
+
+                    f(Entity(manager, id), static_cast<Components*>(archetype.GetComponentArray(chunk, typeIndices[I]))[row]...);
+                }
+            }
 
             explicit TypedView(EntityManager *manager) : BaseView<All>(manager) {}
             TypedView(EntityManager *manager, ComponentMask mask) : BaseView<All>(manager, mask) {}
@@ -456,8 +1121,8 @@ namespace Alimer
         class UnpackingView {
         public:
             struct Unpacker {
-                explicit Unpacker(IntrusivePtr<Components> & ... handles)
-                    : handles(std::tuple<IntrusivePtr<Components> & ...>(handles...))
+                explicit Unpacker(Components* & ... handles)
+                    : handles(std::tuple<Components* & ...>(handles...))
                 {
                 }
 
@@ -470,16 +1135,16 @@ namespace Alimer
             private:
                 template <int N, typename C>
                 void unpack_(Alimer::Entity &entity) const {
-                    std::get<N>(handles) = entity.component<C>();
+                    std::get<N>(handles) = entity.GetComponent<C>();
                 }
 
                 template <int N, typename C0, typename C1, typename ... Cn>
                 void unpack_(Alimer::Entity &entity) const {
-                    std::get<N>(handles) = entity.component<C0>();
+                    std::get<N>(handles) = entity.GetComponent<C0>();
                     unpack_<N + 1, C1, Cn...>(entity);
                 }
 
-                std::tuple<IntrusivePtr<Components> & ...> handles;
+                std::tuple<Components* & ...> handles;
             };
 
 
@@ -510,7 +1175,7 @@ namespace Alimer
         private:
             friend class EntityManager;
 
-            UnpackingView(EntityManager *manager, ComponentMask mask, IntrusivePtr<Components> & ... handles)
+            UnpackingView(EntityManager *manager, ComponentMask mask, Components* & ... handles)
                 : manager_(manager), mask_(mask), unpacker_(handles...)
             {
             }
@@ -520,27 +1185,187 @@ namespace Alimer
             Unpacker unpacker_;
         };
 
+        /// Capture entity tables, entity names, value component data and copies of pooled components. Must be called at a sync point.
+        /// Component arrays and pools whose structure and change versions did not move since base was captured from this manager
+        /// are shared with it instead of copied, so components must be modified through Write or marked changed.
+        void SaveSnapshot(EntitySnapshot& snapshot, const EntitySnapshot* base = nullptr);
+
+        /// Restore state captured by SaveSnapshot, marking every restored component added and changed. Pooled components
+        /// are restored as fresh copies, the snapshot can be restored again and serves as base of the next SaveSnapshot.
+        /// Snapshots do not survive Reset.
+        void RestoreSnapshot(EntitySnapshot& snapshot);
+
+        /// Return persistent query for entities owning the given components, registering it on first use.
+        /// Registration is not thread-safe, systems obtain their queries in GameSystem::Initialize.
+        template <typename ... Components>
+        EntityQuery& GetQuery()
+        {
+            return GetQuery(component_mask<Components...>());
+        }
+
+        /// Return persistent query for entities owning every component of the mask, registering it on first use.
+        EntityQuery& GetQuery(const ComponentMask& mask);
+
         template <typename ... Components>
         View<Components...> EntitiesWithComponents() {
             auto mask = component_mask<Components ...>();
             return View<Components...>(this, mask);
         }
 
-        template <typename T> struct identity { typedef T type; };
+        /// Invoke f(entity, components...) for every entity with the given components, optionally restricted
+        /// by Changed<T> and Added<T> filters.
+        template <typename ... Components, typename Function, typename... Filters>
+        void Each(Function&& f, const Filters&... filters) {
+            const ComponentMask mask = component_mask<Components...>() | FiltersMask(filters...);
+            View<Components...>(this, mask).each(f, filters...);
+        }
 
-        template <typename ... Components>
-        void Each(typename identity<std::function<void(Entity entity, Components&...)>>::type f) {
-            return EntitiesWithComponents<Components...>().each(f);
+        /// Invoke f(entity, components...) for every entity with the given components, optionally restricted by
+        /// Changed<T> and Added<T> filters, in batches of about grainSize entities executed by the JobSystem. Batches are
+        /// runs of archetype chunks, or ranges of the smallest pool when pooled components or filtered types are involved.
+        /// The callable must be safe to invoke concurrently and must not make structural changes.
+        template <typename ... Components, typename Function, typename... Filters>
+        void EachParallel(Function&& f, uint32_t grainSize = ENTITY_BLOCK_SIZE * 16, const Filters&... filters)
+        {
+            EachParallelImpl<Components...>(f, grainSize,
+                AllValueComponents<Components..., typename FilterComponent<Filters>::Type...>(), filters...);
         }
 
         template <typename ... Components>
-        UnpackingView<Components...> EntitiesWithComponents(IntrusivePtr<Components> & ... components) {
+        UnpackingView<Components...> EntitiesWithComponents(Components* & ... components) {
             auto mask = component_mask<Components...>();
             return UnpackingView<Components...>(this, mask, components...);
         }
 
     private:
         friend class Entity;
+        friend class EntityCommandBuffer;
+        friend class EntityQuery;
+
+        /// Value components only: gather matching chunks, skipping chunks rejected by the filters, and split them
+        /// in runs of whole chunks.
+        template <typename ... Components, typename Function, typename... Filters>
+        void EachParallelImpl(Function& f, uint32_t grainSize, std::true_type, const Filters&... filters)
+        {
+            const ComponentMask mask = component_mask<Components...>() | FiltersMask(filters...);
+
+            std::vector<std::pair<Archetype*, uint32_t>> chunks;
+            size_t entityCount = 0;
+            for (Archetype* archetype : _archetypeList)
+            {
+                if (!archetype->GetMask().Contains(mask))
+                    continue;
+
+                for (uint32_t i = 0; i < archetype->GetChunkCount(); ++i)
+                {
+                    const ArchetypeChunk& chunk = archetype->GetChunk(i);
+                    if (!chunk.count || !MatchesChunkFilters(*archetype, chunk, filters...))
+                        continue;
+
+                    chunks.emplace_back(archetype, i);
+                    entityCount += chunk.count;
+                }
+            }
+
+            if (chunks.empty())
+                return;
+
+            // Chunks per batch for about grainSize entities, chunks are never split.
+            const uint32_t chunkCount = static_cast<uint32_t>(chunks.size());
+            const uint32_t chunkGrain = static_cast<uint32_t>(std::max<size_t>(1, size_t(grainSize) * chunkCount / entityCount));
+            auto batch = [this, &chunks, &f, &filters...](uint32_t begin, uint32_t end) {
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    View<Components...>::EachInChunk(this, *chunks[i].first, chunks[i].second, f,
+                        std::index_sequence_for<Components...>(), filters...);
+                }
+            };
+
+            JobSystem* jobs = Object::GetSubsystem<JobSystem>();
+            if (jobs)
+            {
+                jobs->ParallelFor(chunkCount, chunkGrain, batch);
+            }
+            else
+            {
+                batch(0, chunkCount);
+            }
+        }
+
+        /// Pooled components or filtered types present: split the dense array of the smallest pool.
+        template <typename ... Components, typename Function, typename... Filters>
+        void EachParallelImpl(Function& f, uint32_t grainSize, std::false_type, const Filters&... filters)
+        {
+            const ComponentStorage* pool = GetSmallestPool<Components..., typename FilterComponent<Filters>::Type...>();
+            if (!pool)
+                return;
+
+            const ComponentMask mask = component_mask<Components...>() | FiltersMask(filters...);
+            auto batch = [this, pool, &mask, &f, &filters...](uint32_t begin, uint32_t end) {
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    const Entity::Id id = pool->GetEntityAt(i);
+                    if (_entityComponentMask[id.index()].Contains(mask) && MatchesFilters(id, filters...))
+                    {
+                        f(Entity(this, id), *GetComponentImpl<Components>(IsValueComponent<Components>(), id)...);
+                    }
+                }
+            };
+
+            const uint32_t count = static_cast<uint32_t>(pool->size());
+            JobSystem* jobs = Object::GetSubsystem<JobSystem>();
+            if (jobs)
+            {
+                jobs->ParallelFor(count, grainSize, batch);
+            }
+            else
+            {
+                batch(0, count);
+            }
+        }
+
+        /// Return the pool with the fewest components among the pooled components, or null when one has no pool.
+        template <typename ... Components>
+        const ComponentStorage* GetSmallestPool() const
+        {
+            const uint32_t families[] = { IsValueComponent<Components>::value ? ~0u : ComponentIDMapping::GetId<Components>()... };
+
+            const ComponentStorage* smallest = nullptr;
+            for (uint32_t family : families)
+            {
+                if (family == ~0u)
+                    continue;
+
+                const ComponentStorage* pool = family < _componentPools.size() ? _componentPools[family].get() : nullptr;
+                if (!pool)
+                    return nullptr;
+
+                if (!smallest || pool->size() < smallest->size())
+                    smallest = pool;
+            }
+
+            return smallest;
+        }
+
+        /// Recompute block mask containing the entity index after components were removed.
+        void UpdateBlockMask(uint32_t index);
+
+        /// Add entity to or remove it from the queries requiring family and advance the family structure version,
+        /// after its mask changed.
+        void UpdateQueries(Entity::Id id, uint32_t family);
+        /// Insert every matching entity into an empty query.
+        void PopulateQuery(EntityQuery& query);
+
+        /// Destroy entity components and release its slot, without updating the block mask. Returns entity index.
+        uint32_t DestroyEntity(Entity::Id id);
+
+        /// Construct copies of the prototypes for freshly created entities without components.
+        template <typename... Components>
+        void AssignValues(uint32_t count, const Entity::Id* ids, const Components&... prototypes)
+        {
+            const ComponentPrototype prototypeArray[] = { { ComponentTypeInfo::Get<Components>(), &prototypes }... };
+            AssignMany(count, ids, prototypeArray, static_cast<uint32_t>(sizeof...(Components)));
+        }
 
         inline void AssertValid(Entity::Id id) const
         {
@@ -575,29 +1400,209 @@ namespace Alimer
             return component_mask<C1>() | component_mask<C2, Components...>();
         }
 
+        static ComponentMask FiltersMask()
+        {
+            return ComponentMask();
+        }
+
+        template <typename Filter, typename... Filters>
+        static ComponentMask FiltersMask(const Filter& filter, const Filters&... filters)
+        {
+            return FilterMask(filter) | FiltersMask(filters...);
+        }
+
+        template <typename T>
+        static ComponentMask FilterMask(const Changed<T>&)
+        {
+            return ComponentMask().set(ComponentIDMapping::GetId<T>());
+        }
+
+        template <typename T>
+        static ComponentMask FilterMask(const Added<T>&)
+        {
+            return ComponentMask().set(ComponentIDMapping::GetId<T>());
+        }
+
+        bool MatchesFilters(Entity::Id id) const
+        {
+            ALIMER_UNUSED(id);
+            return true;
+        }
+
+        template <typename Filter, typename... Filters>
+        bool MatchesFilters(Entity::Id id, const Filter& filter, const Filters&... filters) const
+        {
+            return MatchesFilter(id, filter) && MatchesFilters(id, filters...);
+        }
+
+        template <typename T>
+        bool MatchesFilter(Entity::Id id, const Changed<T>& filter) const
+        {
+            return GetChangedVersion(id, ComponentIDMapping::GetId<T>()) > filter.version;
+        }
+
+        template <typename T>
+        bool MatchesFilter(Entity::Id id, const Added<T>& filter) const
+        {
+            return GetAddedVersion(id, ComponentIDMapping::GetId<T>()) > filter.version;
+        }
+
+        static bool MatchesChunkFilters(const Archetype& archetype, const ArchetypeChunk& chunk)
+        {
+            ALIMER_UNUSED(archetype);
+            ALIMER_UNUSED(chunk);
+            return true;
+        }
+
+        /// Chunk level test, components are assigned and changed at or below the chunk change version.
+        template <typename Filter, typename... Filters>
+        static bool MatchesChunkFilters(const Archetype& archetype, const ArchetypeChunk& chunk, const Filter& filter, const Filters&... filters)
+        {
+            const uint32_t typeIndex = archetype.GetTypeIndex(FilterFamily(filter));
+            if (typeIndex != Archetype::NPOS && archetype.GetChangeVersion(chunk, typeIndex) <= filter.version)
+                return false;
+
+            return MatchesChunkFilters(archetype, chunk, filters...);
+        }
+
+        template <typename T>
+        static uint32_t FilterFamily(const Changed<T>&) { return ComponentIDMapping::GetId<T>(); }
+
+        template <typename T>
+        static uint32_t FilterFamily(const Added<T>&) { return ComponentIDMapping::GetId<T>(); }
+
+        /// Return detached copy of a pooled component for a snapshot, or the component itself when shared.
+        static ComponentHandle CopyForSnapshot(const ComponentHandle& component);
+
+        /// Stamp added and changed versions of a freshly assigned component.
+        void StampAdded(Entity::Id id, uint32_t family);
+        /// Return versions of a component, stored next to it in its archetype chunk or pool, or null if absent.
+        ComponentVersion* GetComponentVersion(Entity::Id id, uint32_t family) const;
+
         inline void AccomodateEntity(std::uint32_t index)
         {
             if (_entityComponentMask.size() <= index)
             {
-                _entityComponentMask.resize(index + 1);
-                _entityVersion.resize(index + 1);
-                for (auto& pool : _componentPools)
+                // Grow capacity geometrically. Pools are sparse sets and grow with their own component count.
+                if (_entityComponentMask.capacity() <= index)
                 {
-                    if (pool)
-                    {
-                        pool->Expand(index + 1);
-                    }
+                    const size_t capacity = std::max(size_t(index) + 1, _entityComponentMask.capacity() * 2);
+                    _entityComponentMask.reserve(capacity);
+                    _entityVersion.reserve(capacity);
+                    _entityLocation.reserve(capacity);
                 }
+
+                _entityComponentMask.resize(index + 1);
+                _entityVersion.resize(index + 1);
+                _entityLocation.resize(index + 1);
+                _blockComponentMask.resize(index / ENTITY_BLOCK_SIZE + 1);
             }
         }
 
         template <typename C>
         ComponentStorage& AccomodateComponent()
         {
-            auto family = rtti::type_index_sequential_t::id<Component, C>();
+            auto family = ComponentIDMapping::GetId<C>();
             return AccomodateComponent(family);
         }
 
+        template <typename T, typename... Args>
+        IntrusivePtr<T> AssignImpl(std::false_type, Entity::Id id, Args&&... args)
+        {
+            IntrusivePtr<T> handle = MakeHandle<T>(std::forward<Args>(args)...);
+            Assign(id, handle);
+            return handle;
+        }
+
+        template <typename T, typename... Args>
+        T* AssignImpl(std::true_type, Entity::Id id, Args&&... args)
+        {
+            void* storage = AssignValueComponent(id, ComponentTypeInfo::Get<T>());
+            return new (storage) T(std::forward<Args>(args)...);
+        }
+
+        template <typename T>
+        T* GetComponentImpl(std::false_type, Entity::Id id)
+        {
+            auto family = ComponentIDMapping::GetId<T>();
+            if (family >= _componentPools.size())
+            {
+                return nullptr;
+            }
+            auto& pool = _componentPools[family];
+            if (!pool || !_entityComponentMask[id.index()].test(family))
+            {
+                return nullptr;
+            }
+            return pool->template Get<T>(id.index());
+        }
+
+        template <typename T>
+        T* GetComponentImpl(std::true_type, Entity::Id id)
+        {
+            return static_cast<T*>(GetValueComponent(id, ComponentIDMapping::GetId<T>()));
+        }
+
+        template <typename T>
+        T* WriteImpl(std::true_type, Entity::Id id)
+        {
+            return GetComponentImpl<T>(std::true_type(), id);
+        }
+
+        template <typename T>
+        T* WriteImpl(std::false_type, Entity::Id id)
+        {
+            T* component = GetComponentImpl<T>(std::false_type(), id);
+            if (component && component->IsShared())
+            {
+                component = CopyShared<T>(id, *component);
+            }
+            return component;
+        }
+
+        /// Replace shared component of entity with a private copy.
+        template <typename T>
+        T* CopyShared(Entity::Id id, T& shared)
+        {
+            ComponentHandle copy = shared.Clone();
+            if (!copy)
+            {
+                assert(false && "Shared component is not copy constructible and can not be written");
+                return &shared;
+            }
+
+            // Pointers cached from the shared component no longer refer to this entity's.
+            const uint32_t family = ComponentIDMapping::GetId<T>();
+            copy->_entity = Get(id);
+            _componentPools[family]->Set(id, copy);
+            MarkStructureChanged(family);
+            return static_cast<T*>(copy.Get());
+        }
+
+        /// Location of an entity inside archetype storage.
+        struct EntityLocation
+        {
+            Archetype* archetype = nullptr;
+            uint32_t chunk = 0;
+            uint32_t row = 0;
+        };
+
+        /// Move entity to archetype with the given component added and return uninitialized storage for it.
+        /// If the entity already owns the component it is destroyed and its storage returned.
+        void* AssignValueComponent(Entity::Id id, const ComponentTypeInfo* type);
+        /// Destroy value component and move entity to the archetype without it.
+        void RemoveValueComponent(Entity::Id id, uint32_t family);
+        /// Return value component storage, or null.
+        void* GetValueComponent(Entity::Id id, uint32_t family) const;
+        /// Move entity rows to another archetype, relocating shared components and destroying the rest.
+        void MoveEntity(Entity::Id id, Archetype* target);
+        /// Release the entity archetype row, destroying its components.
+        void ReleaseEntityRow(Entity::Id id);
+        /// Advance structure version of every family of an archetype whose rows were moved.
+        void MarkRowsMoved(const Archetype& archetype);
+        /// Return or create archetype for the given value component mask.
+        Archetype* GetArchetype(const ComponentMask& mask, std::vector<const ComponentTypeInfo*> types);
+
         ComponentStorage& AccomodateComponent(uint32_t family)
         {
             if (_componentPools.size() <= family)
@@ -609,7 +1614,6 @@ namespace Alimer
             if (!pool)
             {
                 pool = std::make_unique<ComponentStorage>();
-                pool->Expand(_indexCounter);
             }
 
             return *pool;
@@ -626,12 +1630,54 @@ namespace Alimer
         std::vector<uint32_t> _entityVersion;
         // List of available entity slots.
         std::vector<uint32_t> _freeList;
-        /// Map of entity names.
-        std::unordered_map<std::uint64_t, std::string> _entityNames;
+        // Union of the component masks of each ENTITY_BLOCK_SIZE entity slots.
+        std::vector<ComponentMask> _blockComponentMask;
+        // Archetype location of each entity, archetype is null without value components.
+        std::vector<EntityLocation> _entityLocation;
+        // Archetypes by value component mask.
+        std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> _archetypes;
+        // Archetypes in creation order, for iteration.
+        std::vector<Archetype*> _archetypeList;
+        /// Entity names.
+        EntityNameTable _entityNames;
+        // Current change version.
+        std::atomic<uint32_t> _version{ 1 };
+        /// Source of structure versions.
+        uint32_t _structureVersion = 0;
+        /// Structure version of the last restore or reset, the floor of every family.
+        uint32_t _baseStructureVersion = 0;
+        /// Structure version by family.
+        std::vector<uint32_t> _familyStructureVersions;
+        // Number of ids reserved from the back of the free list.
+        std::atomic<uint32_t> _reservedFree{ 0 };
+        // Number of ids reserved past _indexCounter.
+        std::atomic<uint32_t> _reservedNew{ 0 };
+        // Default command buffer.
+        std::unique_ptr<EntityCommandBuffer> _commands;
+        // Registered queries by component mask.
+        std::unordered_map<ComponentMask, std::unique_ptr<EntityQuery>> _queries;
+        // Per family, queries requiring it.
+        std::vector<std::vector<EntityQuery*>> _familyQueries;
 
         DISALLOW_COPY_MOVE_AND_ASSIGN(EntityManager);
     };
 
+    template <typename ... Components, typename Function, typename... Filters>
+    void EntityQuery::Each(Function&& f, const Filters&... filters)
+    {
+        for (size_t i = _entities.size(); i-- > 0;)
+        {
+            if (i >= _entities.size())
+                continue;
+
+            const Entity::Id id = _entities.GetEntityAt(i);
+            if (!_manager->MatchesFilters(id, filters...))
+                continue;
+
+            f(Entity(_manager, id), *_manager->GetComponentImpl<Components>(IsValueComponent<Components>(), id)...);
+        }
+    }
+
     inline bool Entity::IsValid() const
     {
         return (_manager != nullptr) && _manager->IsValid(_id);
@@ -651,7 +1697,7 @@ namespace Alimer
     }
 
     template <typename T, typename... Args>
-    IntrusivePtr<T> Entity::Assign(Args&&... args)
+    ComponentRef<T> Entity::Assign(Args&&... args)
     {
         ALIMER_ASSERT(IsValid());
         return _manager->Assign<T>(_id, std::forward<Args>(args)...);
@@ -696,12 +1742,33 @@ namespace Alimer
         return _manager->HasComponent(_id, component);
     }
 
+    template <typename T>
+    T* Entity::Write() const
+    {
+        assert(IsValid());
+        return _manager->Write<T>(_id);
+    }
+
     template <typename T>
     T* Entity::GetComponent() const
     {
         assert(IsValid());
         return _manager->GetComponent<T>(_id);
     }
+
+    template <typename T>
+    void Entity::MarkStructureChanged() const
+    {
+        assert(IsValid());
+        _manager->MarkStructureChanged(ComponentIDMapping::GetId<T>());
+    }
+
+    template <typename T>
+    void Entity::MarkChanged() const
+    {
+        assert(IsValid());
+        _manager->MarkChanged<T>(_id);
+    }
 }
 
 namespace std
@@ -0,0 +1,261 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Scene/EntityCommandBuffer.h"
+#include "../Core/Log.h"
+using namespace std;
+
+namespace Alimer
+{
+    static constexpr size_t COMMAND_BLOCK_SIZE = 16 * 1024;
+    static constexpr size_t COMMAND_ALIGNMENT = alignof(max_align_t);
+
+    static inline size_t AlignCommandSize(size_t size)
+    {
+        return (size + COMMAND_ALIGNMENT - 1) & ~(COMMAND_ALIGNMENT - 1);
+    }
+
+    EntityCommandBuffer::EntityCommandBuffer(EntityManager& entities)
+        : _entities(entities)
+    {
+        UpdateStreams();
+    }
+
+    EntityCommandBuffer::~EntityCommandBuffer()
+    {
+        Clear();
+
+        for (Stream& stream : _streams)
+        {
+            for (Block& block : stream.blocks)
+            {
+                free(block.data);
+            }
+        }
+
+        for (Block& block : _sharedStream.blocks)
+        {
+            free(block.data);
+        }
+    }
+
+    Entity::Id EntityCommandBuffer::Create()
+    {
+        return _entities.ReserveId();
+    }
+
+    void EntityCommandBuffer::Destroy(Entity::Id id)
+    {
+        Record(CommandType::Destroy, id, 0);
+    }
+
+    void EntityCommandBuffer::Assign(Entity::Id id, const ComponentHandle& component)
+    {
+        Command* command = Record(CommandType::AssignHandle, id, sizeof(ComponentHandle));
+        new (GetPayload(command)) ComponentHandle(component);
+    }
+
+    void EntityCommandBuffer::Remove(Entity::Id id, uint32_t family)
+    {
+        Command* command = Record(CommandType::Remove, id, 0);
+        command->family = family;
+    }
+
+    void EntityCommandBuffer::Playback()
+    {
+        // Grow entity storage once for every id reserved since the last sync point.
+        _entities.FlushReserved();
+
+        auto execute = [this](Command* command) { Execute(command); };
+        for (Stream& stream : _streams)
+        {
+            Drain(stream, execute);
+        }
+        Drain(_sharedStream, execute);
+
+        UpdateStreams();
+    }
+
+    void EntityCommandBuffer::Clear()
+    {
+        for (Stream& stream : _streams)
+        {
+            Drain(stream, Discard);
+        }
+        Drain(_sharedStream, Discard);
+
+        UpdateStreams();
+    }
+
+    bool EntityCommandBuffer::IsEmpty() const
+    {
+        for (const Stream& stream : _streams)
+        {
+            if (stream.count)
+                return false;
+        }
+
+        return _sharedStream.count == 0;
+    }
+
+    void EntityCommandBuffer::UpdateStreams()
+    {
+        JobSystem* jobs = Object::GetSubsystem<JobSystem>();
+        const size_t count = jobs ? jobs->GetWorkerCount() + 1 : 1;
+        if (_streams.size() < count)
+        {
+            _streams.resize(count);
+        }
+    }
+
+    EntityCommandBuffer::Command* EntityCommandBuffer::Record(CommandType type, Entity::Id id, size_t payloadSize)
+    {
+        // The stream table only grows at sync points, so threads started since fall back to the shared stream.
+        const uint32_t threadIndex = JobSystem::GetCurrentThreadIndex();
+        if (threadIndex < _streams.size())
+            return Record(_streams[threadIndex], type, id, payloadSize);
+
+        std::lock_guard<std::mutex> lock(_sharedMutex);
+        return Record(_sharedStream, type, id, payloadSize);
+    }
+
+    EntityCommandBuffer::Command* EntityCommandBuffer::Record(Stream& stream, CommandType type, Entity::Id id, size_t payloadSize)
+    {
+        const size_t size = AlignCommandSize(sizeof(Command) + payloadSize);
+        while (stream.current < stream.blocks.size()
+            && stream.blocks[stream.current].capacity - stream.blocks[stream.current].used < size)
+        {
+            stream.current++;
+        }
+
+        if (stream.current == stream.blocks.size())
+        {
+            const size_t capacity = max(COMMAND_BLOCK_SIZE, size);
+            stream.blocks.push_back({ static_cast<uint8_t*>(malloc(capacity)), capacity, 0 });
+        }
+
+        Block& block = stream.blocks[stream.current];
+        Command* command = reinterpret_cast<Command*>(block.data + block.used);
+        block.used += size;
+        stream.count++;
+
+        command->type = type;
+        command->size = static_cast<uint32_t>(size);
+        command->id = id;
+        command->family = 0;
+        command->typeInfo = nullptr;
+        return command;
+    }
+
+    void* EntityCommandBuffer::GetPayload(Command* command)
+    {
+        return reinterpret_cast<uint8_t*>(command) + AlignCommandSize(sizeof(Command));
+    }
+
+    void EntityCommandBuffer::Discard(Command* command)
+    {
+        switch (command->type)
+        {
+        case CommandType::AssignValue:
+            command->typeInfo->destruct(GetPayload(command));
+            break;
+
+        case CommandType::AssignHandle:
+            static_cast<ComponentHandle*>(GetPayload(command))->~ComponentHandle();
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void EntityCommandBuffer::Execute(Command* command)
+    {
+        const Entity::Id id = command->id;
+        if (!_entities.IsValid(id))
+        {
+            // Entity was destroyed earlier in the batch.
+            Discard(command);
+            return;
+        }
+
+        switch (command->type)
+        {
+        case CommandType::Destroy:
+            _entities.Destroy(id);
+            break;
+
+        case CommandType::AssignValue:
+        {
+            void* storage = _entities.AssignValueComponent(id, command->typeInfo);
+            command->typeInfo->relocate(storage, GetPayload(command));
+            break;
+        }
+
+        case CommandType::AssignHandle:
+        {
+            ComponentHandle* handle = static_cast<ComponentHandle*>(GetPayload(command));
+            _entities.Assign(id, *handle);
+            handle->~ComponentHandle();
+            break;
+        }
+
+        case CommandType::Remove:
+            if (_entities.HasComponent(id, command->family))
+            {
+                _entities.Remove(id, command->family);
+            }
+            break;
+        }
+    }
+
+    template <typename Function>
+    void EntityCommandBuffer::Drain(Stream& stream, Function&& func)
+    {
+        if (!stream.count)
+            return;
+
+        ForEach(stream, func);
+        for (Block& block : stream.blocks)
+        {
+            block.used = 0;
+        }
+        stream.current = 0;
+        stream.count = 0;
+    }
+
+    template <typename Function>
+    void EntityCommandBuffer::ForEach(Stream& stream, Function&& func)
+    {
+        for (uint32_t i = 0; i <= stream.current && i < stream.blocks.size(); ++i)
+        {
+            Block& block = stream.blocks[i];
+            size_t offset = 0;
+            while (offset < block.used)
+            {
+                Command* command = reinterpret_cast<Command*>(block.data + offset);
+                offset += command->size;
+                func(command);
+            }
+        }
+    }
+}
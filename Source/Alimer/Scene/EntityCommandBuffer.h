@@ -0,0 +1,163 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Scene/Entity.h"
+#include <cstddef>
+#include <mutex>
+
+namespace Alimer
+{
+    /// Records structural changes (create, destroy, assign, remove) and applies them in one batch at a sync point.
+    /// Each thread records into its own linear buffer, so recording is safe from inside Each and EachParallel.
+    /// Threads without a buffer of their own, foreign or started since the last sync point, share a locked one.
+    class ALIMER_API EntityCommandBuffer final
+    {
+    public:
+        /// Constructor. Allocates one command stream per JobSystem thread, more are added at sync points as workers appear.
+        explicit EntityCommandBuffer(EntityManager& entities);
+
+        /// Destructor. Discards pending commands.
+        ~EntityCommandBuffer();
+
+        /// Reserve a new entity id. The entity becomes alive at the next playback even if no other command refers to it.
+        Entity::Id Create();
+
+        /// Record entity destruction.
+        void Destroy(Entity::Id id);
+
+        /// Record component assignment. Arguments are consumed now, the component is constructed at playback.
+        template <typename T, typename... Args>
+        void Assign(Entity::Id id, Args&&... args)
+        {
+            AssignImpl<T>(IsValueComponent<T>(), id, std::forward<Args>(args)...);
+        }
+
+        /// Record component assignment.
+        void Assign(Entity::Id id, const ComponentHandle& component);
+
+        /// Record component removal.
+        template <typename T>
+        void Remove(Entity::Id id)
+        {
+            Remove(id, ComponentIDMapping::GetId<T>());
+        }
+
+        /// Record component removal by family.
+        void Remove(Entity::Id id, uint32_t family);
+
+        /// Apply all recorded commands, thread streams in thread index order and the shared stream last, then clear.
+        /// Must be called from a sync point.
+        void Playback();
+
+        /// Discard all recorded commands.
+        void Clear();
+
+        /// Return whether no command was recorded.
+        bool IsEmpty() const;
+
+    private:
+        enum class CommandType : uint32_t
+        {
+            Destroy,
+            AssignValue,
+            AssignHandle,
+            Remove
+        };
+
+        /// Command header, followed by the payload when present.
+        struct Command
+        {
+            CommandType type;
+            /// Total size including header and payload.
+            uint32_t size;
+            Entity::Id id;
+            /// Removed family, or value component type.
+            uint32_t family;
+            const ComponentTypeInfo* typeInfo;
+        };
+
+        /// Fixed size memory block, commands never move once recorded.
+        struct Block
+        {
+            uint8_t* data;
+            size_t capacity;
+            size_t used;
+        };
+
+        /// Linear command storage owned by one thread.
+        struct Stream
+        {
+            std::vector<Block> blocks;
+            uint32_t current = 0;
+            uint32_t count = 0;
+        };
+
+        template <typename T, typename... Args>
+        void AssignImpl(std::false_type, Entity::Id id, Args&&... args)
+        {
+            Assign(id, MakeHandle<T>(std::forward<Args>(args)...));
+        }
+
+        template <typename T, typename... Args>
+        void AssignImpl(std::true_type, Entity::Id id, Args&&... args)
+        {
+            static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned components are not supported.");
+
+            const ComponentTypeInfo* type = ComponentTypeInfo::Get<T>();
+            Command* command = Record(CommandType::AssignValue, id, sizeof(T));
+            command->family = type->family;
+            command->typeInfo = type;
+            new (GetPayload(command)) T(std::forward<Args>(args)...);
+        }
+
+        /// Append command with payload of the given size to the calling thread stream.
+        Command* Record(CommandType type, Entity::Id id, size_t payloadSize);
+        /// Append command to the given stream.
+        static Command* Record(Stream& stream, CommandType type, Entity::Id id, size_t payloadSize);
+        /// Invoke func on every command of a stream, then rewind it.
+        template <typename Function>
+        static void Drain(Stream& stream, Function&& func);
+        /// Add streams for JobSystem threads created since. Must be called from a sync point.
+        void UpdateStreams();
+        /// Return payload storage following the command header.
+        static void* GetPayload(Command* command);
+        /// Destroy payload without executing the command.
+        static void Discard(Command* command);
+        /// Execute command against the entity manager and destroy its payload.
+        void Execute(Command* command);
+        /// Invoke func on every command of a stream in record order.
+        template <typename Function>
+        static void ForEach(Stream& stream, Function&& func);
+
+        EntityManager& _entities;
+        /// Streams by JobSystem thread index.
+        std::vector<Stream> _streams;
+        /// Stream of threads without one of their own.
+        Stream _sharedStream;
+        /// Shared stream lock.
+        std::mutex _sharedMutex;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(EntityCommandBuffer);
+    };
+}
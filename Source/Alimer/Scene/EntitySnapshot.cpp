@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Scene/EntitySnapshot.h"
+#include <algorithm>
+#include <cstring>
+using namespace std;
+
+namespace Alimer
+{
+    EntitySnapshot::ArrayCopy::ArrayCopy(const ComponentTypeInfo* type, const void* source, uint32_t count)
+        : type(type)
+        , count(count)
+        , data(static_cast<uint8_t*>(malloc(GetSize())))
+    {
+        if (!type || type->trivial)
+        {
+            memcpy(data, source, GetSize());
+            return;
+        }
+
+        assert(type->copy && "Value component is not copy constructible and can not be captured");
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            type->copy(data + i * type->size, static_cast<const uint8_t*>(source) + i * type->size);
+        }
+    }
+
+    EntitySnapshot::ArrayCopy::~ArrayCopy()
+    {
+        if (type && !type->trivial)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                type->destruct(data + i * type->size);
+            }
+        }
+        free(data);
+    }
+
+    void EntitySnapshot::Clear()
+    {
+        _version = 0;
+        _structureVersion = 0;
+        _indexCounter = 0;
+        _entityVersions.clear();
+        _freeList.clear();
+        _archetypes.clear();
+        _pools.clear();
+        _names.clear();
+    }
+
+    size_t EntitySnapshot::GetMemoryUsage() const
+    {
+        return GetMemoryUsage(nullptr);
+    }
+
+    size_t EntitySnapshot::GetMemoryUsage(std::unordered_set<const void*>* counted) const
+    {
+        size_t size = (_entityVersions.capacity() + _freeList.capacity()) * sizeof(uint32_t) +
+            _names.capacity() * sizeof(std::pair<Entity::Id, Name>);
+
+        for (const ArchetypeCopy& archetype : _archetypes)
+        {
+            for (const ChunkCopy& chunk : archetype.chunks)
+            {
+                size += sizeof(ChunkCopy) + chunk.components.capacity() * sizeof(IntrusivePtr<ArrayCopy>);
+                if (!counted || counted->insert(chunk.entities.Get()).second)
+                    size += chunk.entities->GetSize();
+
+                for (const IntrusivePtr<ArrayCopy>& components : chunk.components)
+                {
+                    if (!counted || counted->insert(components.Get()).second)
+                        size += components->GetSize();
+                }
+            }
+        }
+
+        for (const IntrusivePtr<PoolCopy>& pool : _pools)
+        {
+            if (!counted || counted->insert(pool.Get()).second)
+                size += pool->components.capacity() * sizeof(ComponentHandle);
+            if (!counted || counted->insert(pool->entities.Get()).second)
+                size += pool->entities->GetSize();
+        }
+
+        return size;
+    }
+
+    SnapshotRing::SnapshotRing(uint32_t capacity)
+        : _capacity(std::max(capacity, 1u))
+    {
+    }
+
+    void SnapshotRing::Capture(EntityManager& manager)
+    {
+        EntitySnapshot snapshot;
+        manager.SaveSnapshot(snapshot, _snapshots.empty() ? nullptr : &_snapshots.front());
+
+        _snapshots.push_front(std::move(snapshot));
+        if (_snapshots.size() > _capacity)
+        {
+            _snapshots.pop_back();
+        }
+    }
+
+    bool SnapshotRing::Restore(EntityManager& manager, uint32_t age)
+    {
+        if (age >= GetSize())
+            return false;
+
+        _snapshots.erase(_snapshots.begin(), _snapshots.begin() + age);
+        manager.RestoreSnapshot(_snapshots.front());
+        return true;
+    }
+
+    void SnapshotRing::Clear()
+    {
+        _snapshots.clear();
+    }
+
+    size_t SnapshotRing::GetMemoryUsage() const
+    {
+        std::unordered_set<const void*> counted;
+        size_t size = 0;
+        for (const EntitySnapshot& snapshot : _snapshots)
+        {
+            size += snapshot.GetMemoryUsage(&counted);
+        }
+        return size;
+    }
+}
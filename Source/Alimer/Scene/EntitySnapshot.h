@@ -0,0 +1,163 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Scene/Entity.h"
+#include <cstddef>
+#include <deque>
+#include <unordered_set>
+#include <vector>
+
+namespace Alimer
+{
+    /// Copy of EntityManager state taken by EntityManager::SaveSnapshot: entity tables, free list, entity names, component masks
+    /// (implied by archetype membership and pool ownership) and component data. Value components are copied per chunk
+    /// and component array, pooled components per family as copies made through BaseComponent::Clone, shared ones by
+    /// reference. Arrays and pools are immutable once captured, so consecutive snapshots share the ones that did not change.
+    class ALIMER_API EntitySnapshot final
+    {
+    public:
+        /// Construct empty snapshot.
+        EntitySnapshot() = default;
+
+        EntitySnapshot(EntitySnapshot&& other) = default;
+        EntitySnapshot& operator =(EntitySnapshot&& other) = default;
+
+        /// Release all data.
+        void Clear();
+
+        /// Return whether nothing was captured.
+        bool IsEmpty() const { return !_version; }
+
+        /// Return approximate memory use in bytes, counting data shared with other snapshots.
+        size_t GetMemoryUsage() const;
+
+    private:
+        friend class EntityManager;
+        friend class SnapshotRing;
+
+        /// Return approximate memory use in bytes, skipping arrays and pools already in counted.
+        size_t GetMemoryUsage(std::unordered_set<const void*>* counted) const;
+
+        /// Copy of the entity ids of a chunk or pool, or one component array of a chunk.
+        class ArrayCopy final : public IntrusivePtrEnabled<ArrayCopy>
+        {
+        public:
+            /// Construct by copying count elements. Type is null for entity ids.
+            ArrayCopy(const ComponentTypeInfo* type, const void* source, uint32_t count);
+            /// Destructor. Destroys copied components.
+            ~ArrayCopy();
+
+            /// Return size of the copy in bytes.
+            size_t GetSize() const { return count * (type ? type->size : sizeof(Entity::Id)); }
+
+            const ComponentTypeInfo* type;
+            uint32_t count;
+            uint8_t* data;
+
+            DISALLOW_COPY_MOVE_AND_ASSIGN(ArrayCopy);
+        };
+
+        /// Copied chunk: entity ids and one array per archetype type.
+        struct ChunkCopy
+        {
+            IntrusivePtr<ArrayCopy> entities;
+            std::vector<IntrusivePtr<ArrayCopy>> components;
+        };
+
+        /// Copied archetype rows.
+        struct ArchetypeCopy
+        {
+            /// Index in the entity manager archetype list.
+            uint32_t index;
+            std::vector<ChunkCopy> chunks;
+        };
+
+        /// Copied pool of one component family, in dense order.
+        class PoolCopy final : public IntrusivePtrEnabled<PoolCopy>
+        {
+        public:
+            PoolCopy() = default;
+
+            uint32_t family = 0;
+            IntrusivePtr<ArrayCopy> entities;
+            std::vector<ComponentHandle> components;
+
+            DISALLOW_COPY_MOVE_AND_ASSIGN(PoolCopy);
+        };
+
+        /// Change version at capture, zero when empty. Components stamped later changed after the capture.
+        uint32_t _version = 0;
+        /// Structure version at capture. Families whose structure version is higher moved after the capture.
+        uint32_t _structureVersion = 0;
+        /// Entity index counter.
+        uint32_t _indexCounter = 0;
+        /// Entity versions by index.
+        std::vector<uint32_t> _entityVersions;
+        /// Free entity indices.
+        std::vector<uint32_t> _freeList;
+        /// Non-empty archetypes by ascending index.
+        std::vector<ArchetypeCopy> _archetypes;
+        /// Non-empty pools by ascending family.
+        std::vector<IntrusivePtr<PoolCopy>> _pools;
+        /// Named entities.
+        std::vector<std::pair<Entity::Id, Name>> _names;
+
+        DISALLOW_COPY_AND_ASSIGN(EntitySnapshot);
+    };
+
+    /// Ring of the last N snapshots for rollback. Each capture is taken against the previous one, so component arrays
+    /// and pools that did not change in between are shared instead of copied, and steady simulations cost little more than one snapshot.
+    class ALIMER_API SnapshotRing final
+    {
+    public:
+        /// Constructor. Capacity is the number of snapshots kept, at least one.
+        explicit SnapshotRing(uint32_t capacity);
+
+        /// Capture entity manager state, dropping the oldest snapshot when full.
+        void Capture(EntityManager& manager);
+
+        /// Restore the snapshot captured age captures ago, zero being the newest. Newer snapshots are discarded,
+        /// so that resimulation captures from there on. Returns false if no such snapshot exists.
+        bool Restore(EntityManager& manager, uint32_t age = 0);
+
+        /// Drop all snapshots.
+        void Clear();
+
+        /// Return number of snapshots kept.
+        uint32_t GetSize() const { return static_cast<uint32_t>(_snapshots.size()); }
+
+        /// Return maximum number of snapshots kept.
+        uint32_t GetCapacity() const { return _capacity; }
+
+        /// Return approximate memory use in bytes, counting shared data once.
+        size_t GetMemoryUsage() const;
+
+    private:
+        uint32_t _capacity;
+        /// Snapshots, newest first.
+        std::deque<EntitySnapshot> _snapshots;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(SnapshotRing);
+    };
+}
@@ -0,0 +1,140 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Scene/Prefab.h"
+using namespace std;
+
+namespace Alimer
+{
+    Prefab::Prefab()
+    {
+    }
+
+    Prefab::~Prefab()
+    {
+        for (const ComponentPrototype& value : _values)
+        {
+            value.type->destruct(const_cast<void*>(value.data));
+            free(const_cast<void*>(value.data));
+        }
+    }
+
+    void Prefab::Set(const ComponentHandle& component, bool shared)
+    {
+        // A component owned by an entity stays with it, the prefab keeps a copy instead.
+        ComponentHandle stored = component->_entity.IsValid() ? component->Clone() : component;
+        if (!stored)
+        {
+            assert(false && "Component owned by an entity is not copy constructible and can not be set");
+            return;
+        }
+
+        // Only the prefab and its instances reference a shared component from now on, and none of them owns it.
+        stored->_shared = shared;
+        stored->_entity = Entity();
+
+        const uint32_t family = component->GetFamily();
+        for (ComponentHandle& existing : _pooled)
+        {
+            if (existing->GetFamily() == family)
+            {
+                existing = stored;
+                return;
+            }
+        }
+
+        _pooled.push_back(stored);
+    }
+
+    void Prefab::Remove(uint32_t family)
+    {
+        for (size_t i = 0; i < _values.size(); ++i)
+        {
+            if (_values[i].type->family == family)
+            {
+                _values[i].type->destruct(const_cast<void*>(_values[i].data));
+                free(const_cast<void*>(_values[i].data));
+                _values.erase(_values.begin() + i);
+                return;
+            }
+        }
+
+        for (size_t i = 0; i < _pooled.size(); ++i)
+        {
+            if (_pooled[i]->GetFamily() == family)
+            {
+                _pooled.erase(_pooled.begin() + i);
+                return;
+            }
+        }
+    }
+
+    void Prefab::Instantiate(EntityManager& entities, uint32_t count, Entity::Id* ids) const
+    {
+        entities.CreateMany(count, ids);
+        entities.AssignMany(count, ids, _values.data(), static_cast<uint32_t>(_values.size()));
+
+        for (const ComponentHandle& component : _pooled)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if (component->_shared)
+                {
+                    entities.Assign(ids[i], component);
+                    continue;
+                }
+
+                ComponentHandle instance = component->Clone();
+                if (!instance)
+                {
+                    assert(false && "Prefab component is not copy constructible, set it as shared instead");
+                    break;
+                }
+
+                entities.Assign(ids[i], instance);
+            }
+        }
+    }
+
+    Entity Prefab::Instantiate(EntityManager& entities) const
+    {
+        Entity::Id id;
+        Instantiate(entities, 1, &id);
+        return entities.Get(id);
+    }
+
+    void* Prefab::AllocateValue(const ComponentTypeInfo* type)
+    {
+        for (ComponentPrototype& value : _values)
+        {
+            if (value.type == type)
+            {
+                type->destruct(const_cast<void*>(value.data));
+                return const_cast<void*>(value.data);
+            }
+        }
+
+        void* data = malloc(type->size);
+        _values.push_back({ type, data });
+        return data;
+    }
+}
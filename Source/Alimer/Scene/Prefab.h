@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Resource/Resource.h"
+#include "../Scene/Entity.h"
+#include <cstddef>
+
+namespace Alimer
+{
+    /// Entity template storing a component set once, instantiated any number of times.
+    /// Value components are copied straight into the archetype rows of the instances, with memcpy when trivially copyable.
+    /// Pooled components are cloned for every instance, unless set as shared: a shared component is referenced by every
+    /// instance and treated as immutable, writing it through Entity::Write replaces it with a private copy for that entity only.
+    class ALIMER_API Prefab final : public Resource
+    {
+        ALIMER_OBJECT(Prefab, Resource);
+
+    public:
+        /// Constructor.
+        Prefab();
+
+        /// Destructor.
+        ~Prefab() override;
+
+        /// Set component template constructed from the arguments, replacing a previous one of the same type.
+        template <typename T, typename... Args>
+        void Set(Args&&... args)
+        {
+            SetImpl<T>(IsValueComponent<T>(), std::forward<Args>(args)...);
+        }
+
+        /// Set pooled component template constructed from the arguments and shared by every instance.
+        template <typename T, typename... Args>
+        void SetShared(Args&&... args)
+        {
+            static_assert(!IsValueComponent<T>::value, "Only pooled components can be shared.");
+            Set(MakeHandle<T>(std::forward<Args>(args)...), true);
+        }
+
+        /// Set pooled component template, cloned for every instance or, when shared, referenced by all of them.
+        /// A component owned by an entity is copied, not taken over.
+        void Set(const ComponentHandle& component, bool shared = false);
+
+        /// Remove component template by family.
+        void Remove(uint32_t family);
+
+        template <typename T>
+        void Remove()
+        {
+            Remove(ComponentIDMapping::GetId<T>());
+        }
+
+        /// Create count entities from the prefab and write their ids.
+        void Instantiate(EntityManager& entities, uint32_t count, Entity::Id* ids) const;
+
+        /// Create one entity from the prefab.
+        Entity Instantiate(EntityManager& entities) const;
+
+    private:
+        template <typename T, typename... Args>
+        void SetImpl(std::true_type, Args&&... args)
+        {
+            static_assert(std::is_copy_constructible<T>::value, "Prefab value components must be copy constructible.");
+            static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned components are not supported.");
+
+            const ComponentTypeInfo* type = ComponentTypeInfo::Get<T>();
+            new (AllocateValue(type)) T(std::forward<Args>(args)...);
+        }
+
+        template <typename T, typename... Args>
+        void SetImpl(std::false_type, Args&&... args)
+        {
+            Set(MakeHandle<T>(std::forward<Args>(args)...));
+        }
+
+        /// Return uninitialized storage for value component, destroying a previous one of the same type.
+        void* AllocateValue(const ComponentTypeInfo* type);
+
+        /// Value component templates.
+        std::vector<ComponentPrototype> _values;
+        /// Pooled component templates, flagged shared when referenced by the instances instead of cloned.
+        std::vector<ComponentHandle> _pooled;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(Prefab);
+    };
+}
@@ -43,7 +43,7 @@ namespace Alimer
     {
     }
 
-    Entity Scene::CreateEntity(const std::string& name)
+    Entity Scene::CreateEntity(const Name& name)
     {
         Entity entity = _entities.Create();
         entity.SetName(name);
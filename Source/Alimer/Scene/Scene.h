@@ -73,7 +73,7 @@ namespace Alimer
         ~Scene();
 
         /// Creates a new entity in the Scene.
-        Entity CreateEntity(const std::string& name);
+        Entity CreateEntity(const Name& name);
 
         /// Return the Entity containing the default camera.
         Entity GetDefaultCamera() const { return _defaultCamera; }
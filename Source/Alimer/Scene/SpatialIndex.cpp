@@ -0,0 +1,323 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Scene/SpatialIndex.h"
+#include "../Core/JobSystem.h"
+#include <algorithm>
+using namespace std;
+
+namespace Alimer
+{
+    /// Maximum proxies per leaf.
+    static constexpr uint32_t SPATIAL_LEAF_SIZE = 4;
+
+    /// Subtrees with more proxies than this are built as separate jobs.
+    static constexpr uint32_t SPATIAL_PARALLEL_BUILD_SIZE = 4096;
+
+    /// Pending insertions and removals tolerated before Commit rebuilds, in addition to a quarter of the size.
+    static constexpr uint32_t SPATIAL_REBUILD_SLACK = 32;
+
+    constexpr uint32_t SpatialIndex::INVALID_SLOT;
+    constexpr uint32_t SpatialIndex::MAX_DEPTH;
+
+    SpatialIndex::SpatialIndex(float margin)
+        : _margin(margin)
+    {
+    }
+
+    void SpatialIndex::Insert(Entity::Id id, const BoundingBox& bounds)
+    {
+        uint32_t slot = GetSlot(id);
+        if (slot != INVALID_SLOT)
+        {
+            Proxy& proxy = _proxies[slot];
+            proxy.bounds = bounds;
+            if (!proxy.fatBounds.Contains(bounds))
+            {
+                proxy.fatBounds = bounds.Inflated(_margin);
+                _refitNeeded = true;
+            }
+            return;
+        }
+
+        if (!_freeSlots.empty())
+        {
+            slot = _freeSlots.back();
+            _freeSlots.pop_back();
+        }
+        else
+        {
+            slot = static_cast<uint32_t>(_proxies.size());
+            _proxies.emplace_back();
+        }
+
+        Proxy& proxy = _proxies[slot];
+        proxy.id = id;
+        proxy.bounds = bounds;
+        proxy.fatBounds = bounds.Inflated(_margin);
+
+        const uint32_t index = id.index();
+        if (index >= _slots.size())
+        {
+            _slots.resize(max<size_t>(index + 1, _slots.size() * 2), INVALID_SLOT);
+        }
+        _slots[index] = slot;
+
+        _pending.push_back(slot);
+        _liveCount++;
+    }
+
+    void SpatialIndex::Remove(Entity::Id id)
+    {
+        const uint32_t slot = GetSlot(id);
+        if (slot == INVALID_SLOT)
+            return;
+
+        // Leaves may still refer to the slot, it becomes reusable at the next rebuild.
+        _proxies[slot].id = Entity::INVALID;
+        _slots[id.index()] = INVALID_SLOT;
+        _removedSlots.push_back(slot);
+        _liveCount--;
+    }
+
+    void SpatialIndex::Clear()
+    {
+        _proxies.clear();
+        _freeSlots.clear();
+        _removedSlots.clear();
+        _slots.clear();
+        _pending.clear();
+        _leafProxies.clear();
+        _nodes.clear();
+        _liveCount = 0;
+        _refitNeeded = false;
+    }
+
+    void SpatialIndex::Commit()
+    {
+        const size_t changes = _pending.size() + _removedSlots.size();
+        if (changes > _liveCount / 4 + SPATIAL_REBUILD_SLACK)
+        {
+            Rebuild();
+        }
+        else if (_refitNeeded)
+        {
+            Refit();
+        }
+    }
+
+    void SpatialIndex::Rebuild()
+    {
+        _freeSlots.insert(_freeSlots.end(), _removedSlots.begin(), _removedSlots.end());
+        _removedSlots.clear();
+        _pending.clear();
+        _refitNeeded = false;
+
+        _leafProxies.clear();
+        _leafProxies.reserve(_liveCount);
+        _centroids.resize(_proxies.size());
+        for (uint32_t slot = 0; slot < _proxies.size(); ++slot)
+        {
+            const Proxy& proxy = _proxies[slot];
+            if (proxy.id != Entity::INVALID)
+            {
+                _leafProxies.push_back(slot);
+                _centroids[slot] = proxy.fatBounds.GetCenter();
+            }
+        }
+
+        const uint32_t count = static_cast<uint32_t>(_leafProxies.size());
+        if (!count)
+        {
+            _nodes.clear();
+            return;
+        }
+
+        // A binary tree over count proxies never has more than 2 * count - 1 nodes.
+        _nodes.resize(2 * count - 1);
+        _nodeCount.store(1, memory_order_relaxed);
+
+        JobSystem* jobs = Object::GetSubsystem<JobSystem>();
+        if (jobs && count > SPATIAL_PARALLEL_BUILD_SIZE)
+        {
+            JobCounter counter;
+            BuildNode(0, 0, count, jobs, &counter);
+            jobs->Wait(counter);
+        }
+        else
+        {
+            BuildNode(0, 0, count, nullptr, nullptr);
+        }
+
+        _nodes.resize(_nodeCount.load(memory_order_relaxed));
+    }
+
+    void SpatialIndex::BuildNode(uint32_t nodeIndex, uint32_t begin, uint32_t end, JobSystem* jobs, JobCounter* counter)
+    {
+        BoundingBox bounds;
+        BoundingBox centroidBounds;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const uint32_t slot = _leafProxies[i];
+            bounds.Merge(_proxies[slot].fatBounds);
+            centroidBounds.Merge(_centroids[slot]);
+        }
+
+        Node& node = _nodes[nodeIndex];
+        node.bounds = bounds;
+
+        const vec3 size = centroidBounds.max - centroidBounds.min;
+        const uint32_t count = end - begin;
+        if (count <= SPATIAL_LEAF_SIZE || (size.x <= 0.0f && size.y <= 0.0f && size.z <= 0.0f))
+        {
+            node.first = begin;
+            node.count = count;
+            return;
+        }
+
+        // Median split along the axis with the largest centroid spread.
+        int axis = 0;
+        if (size.y > size.x)
+            axis = 1;
+        if (size.z > size[axis])
+            axis = 2;
+
+        const uint32_t middle = begin + count / 2;
+        const vec3* centroids = _centroids.data();
+        nth_element(_leafProxies.begin() + begin, _leafProxies.begin() + middle, _leafProxies.begin() + end,
+            [centroids, axis](uint32_t lhs, uint32_t rhs) { return centroids[lhs][axis] < centroids[rhs][axis]; });
+
+        const uint32_t left = _nodeCount.fetch_add(2, memory_order_relaxed);
+        node.first = left;
+        node.count = 0;
+
+        if (jobs && middle - begin > SPATIAL_PARALLEL_BUILD_SIZE)
+        {
+            jobs->Schedule([this, left, begin, middle, jobs, counter]() {
+                BuildNode(left, begin, middle, jobs, counter);
+            }, counter);
+        }
+        else
+        {
+            BuildNode(left, begin, middle, jobs, counter);
+        }
+
+        BuildNode(left + 1, middle, end, jobs, counter);
+    }
+
+    void SpatialIndex::Refit()
+    {
+        _refitNeeded = false;
+
+        // Children are always allocated after their parent, so a reverse pass visits them first.
+        for (size_t i = _nodes.size(); i-- > 0;)
+        {
+            Node& node = _nodes[i];
+            BoundingBox bounds;
+            if (node.count)
+            {
+                for (uint32_t j = node.first; j < node.first + node.count; ++j)
+                {
+                    const Proxy& proxy = _proxies[_leafProxies[j]];
+                    if (proxy.id != Entity::INVALID)
+                        bounds.Merge(proxy.fatBounds);
+                }
+            }
+            else
+            {
+                bounds = _nodes[node.first].bounds;
+                bounds.Merge(_nodes[node.first + 1].bounds);
+            }
+
+            node.bounds = bounds;
+        }
+    }
+
+    Entity::Id SpatialIndex::Raycast(const vec3& origin, const vec3& direction, float maxDistance, float* hitDistance) const
+    {
+        const vec3 invDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+        Entity::Id result = Entity::INVALID;
+        float closest = maxDistance;
+        float distance;
+
+        auto testProxy = [&](uint32_t slot) {
+            const Proxy& proxy = _proxies[slot];
+            if (proxy.id != Entity::INVALID
+                && proxy.bounds.IntersectsRay(origin, invDirection, closest, distance)
+                && (distance < closest || result == Entity::INVALID))
+            {
+                result = proxy.id;
+                closest = distance;
+            }
+        };
+
+        if (!_nodes.empty() && _nodes[0].bounds.IntersectsRay(origin, invDirection, closest, distance))
+        {
+            uint32_t stack[MAX_DEPTH];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = 0;
+            while (stackSize)
+            {
+                const Node& node = _nodes[stack[--stackSize]];
+                if (node.count)
+                {
+                    for (uint32_t i = node.first; i < node.first + node.count; ++i)
+                    {
+                        testProxy(_leafProxies[i]);
+                    }
+                    continue;
+                }
+
+                // Visit the nearer child first, so that the farther one is pruned more often.
+                float leftDistance;
+                float rightDistance;
+                const bool hitLeft = _nodes[node.first].bounds.IntersectsRay(origin, invDirection, closest, leftDistance);
+                const bool hitRight = _nodes[node.first + 1].bounds.IntersectsRay(origin, invDirection, closest, rightDistance);
+                if (hitLeft && hitRight)
+                {
+                    const bool leftFirst = leftDistance <= rightDistance;
+                    stack[stackSize++] = leftFirst ? node.first + 1 : node.first;
+                    stack[stackSize++] = leftFirst ? node.first : node.first + 1;
+                }
+                else if (hitLeft)
+                {
+                    stack[stackSize++] = node.first;
+                }
+                else if (hitRight)
+                {
+                    stack[stackSize++] = node.first + 1;
+                }
+            }
+        }
+
+        for (uint32_t slot : _pending)
+        {
+            testProxy(slot);
+        }
+
+        if (hitDistance && result != Entity::INVALID)
+            *hitDistance = closest;
+
+        return result;
+    }
+}
@@ -0,0 +1,208 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Scene/Entity.h"
+#include "../Math/BoundingBox.h"
+#include "../Math/Frustum.h"
+#include <atomic>
+#include <vector>
+
+namespace Alimer
+{
+    class JobSystem;
+    class JobCounter;
+
+    /// Bounding volume hierarchy over entity bounds, keyed by Entity::Id.
+    /// Every proxy is stored with loose (fat) bounds, so that small movements only update the proxy.
+    /// Larger movements refit the tree, many insertions and removals rebuild it in parallel on Commit.
+    class ALIMER_API SpatialIndex final
+    {
+    public:
+        /// Constructor. Margin is added on every side of the proxy bounds.
+        explicit SpatialIndex(float margin = 0.5f);
+
+        /// Insert entity, or update its bounds when already present.
+        void Insert(Entity::Id id, const BoundingBox& bounds);
+
+        /// Update bounds of entity, inserting it when missing.
+        void Update(Entity::Id id, const BoundingBox& bounds) { Insert(id, bounds); }
+
+        /// Remove entity.
+        void Remove(Entity::Id id);
+
+        /// Remove all entities.
+        void Clear();
+
+        /// Return whether entity is present.
+        bool Contains(Entity::Id id) const { return GetSlot(id) != INVALID_SLOT; }
+
+        /// Return number of entities.
+        uint32_t GetSize() const { return _liveCount; }
+
+        /// Apply pending changes: rebuild when many entities were inserted or removed, refit otherwise.
+        void Commit();
+
+        /// Rebuild the whole hierarchy, splitting large subtrees across the JobSystem.
+        void Rebuild();
+
+        /// Invoke func(id, bounds) for every live entity.
+        template <typename Function>
+        void ForEach(Function&& func) const
+        {
+            for (const Proxy& proxy : _proxies)
+            {
+                if (proxy.id != Entity::INVALID)
+                    func(proxy.id, proxy.bounds);
+            }
+        }
+
+        /// Invoke func(id) for every entity whose bounds overlap the box.
+        template <typename Function>
+        void QueryBox(const BoundingBox& box, Function&& func) const
+        {
+            Query([&box](const BoundingBox& bounds) { return box.Intersects(bounds); }, func);
+        }
+
+        /// Invoke func(id) for every entity whose bounds overlap the sphere.
+        template <typename Function>
+        void QuerySphere(const vec3& center, float radius, Function&& func) const
+        {
+            Query([&center, radius](const BoundingBox& bounds) { return bounds.Intersects(center, radius); }, func);
+        }
+
+        /// Invoke func(id) for every entity whose bounds are at least partially inside the frustum.
+        template <typename Function>
+        void QueryFrustum(const Frustum& frustum, Function&& func) const
+        {
+            Query([&frustum](const BoundingBox& bounds) { return frustum.Intersects(bounds); }, func);
+        }
+
+        /// Return the entity whose bounds are hit first by the ray, or Entity::INVALID.
+        Entity::Id Raycast(const vec3& origin, const vec3& direction, float maxDistance, float* hitDistance = nullptr) const;
+
+    private:
+        static constexpr uint32_t INVALID_SLOT = 0xffffffff;
+
+        struct Proxy
+        {
+            /// Entity::INVALID for a free slot.
+            Entity::Id id;
+            /// Bounds as last reported.
+            BoundingBox bounds;
+            /// Bounds grown by the margin, used by the hierarchy.
+            BoundingBox fatBounds;
+        };
+
+        /// Hierarchy node. Leaves reference count proxies in _leafProxies starting at first,
+        /// inner nodes have two children at first and first + 1.
+        struct Node
+        {
+            BoundingBox bounds;
+            uint32_t first;
+            uint32_t count;
+        };
+
+        uint32_t GetSlot(Entity::Id id) const
+        {
+            const uint32_t index = id.index();
+            if (index >= _slots.size())
+                return INVALID_SLOT;
+
+            const uint32_t slot = _slots[index];
+            return slot != INVALID_SLOT && _proxies[slot].id == id ? slot : INVALID_SLOT;
+        }
+
+        /// Walk the hierarchy and the pending list, invoking func(id) for proxies whose bounds pass the test.
+        template <typename Test, typename Function>
+        void Query(const Test& test, Function& func) const
+        {
+            if (!_nodes.empty() && test(_nodes[0].bounds))
+            {
+                uint32_t stack[MAX_DEPTH];
+                uint32_t stackSize = 0;
+                stack[stackSize++] = 0;
+                while (stackSize)
+                {
+                    const Node& node = _nodes[stack[--stackSize]];
+                    if (node.count)
+                    {
+                        for (uint32_t i = node.first; i < node.first + node.count; ++i)
+                        {
+                            const Proxy& proxy = _proxies[_leafProxies[i]];
+                            if (proxy.id != Entity::INVALID && test(proxy.bounds))
+                                func(proxy.id);
+                        }
+                        continue;
+                    }
+
+                    for (uint32_t child = node.first; child < node.first + 2; ++child)
+                    {
+                        if (test(_nodes[child].bounds))
+                            stack[stackSize++] = child;
+                    }
+                }
+            }
+
+            for (uint32_t slot : _pending)
+            {
+                const Proxy& proxy = _proxies[slot];
+                if (proxy.id != Entity::INVALID && test(proxy.bounds))
+                    func(proxy.id);
+            }
+        }
+
+        /// Build subtree for _leafProxies range [begin, end) into node.
+        void BuildNode(uint32_t nodeIndex, uint32_t begin, uint32_t end, JobSystem* jobs, JobCounter* counter);
+        /// Recompute node bounds bottom-up.
+        void Refit();
+
+        /// Maximum hierarchy depth, bounded by median splits.
+        static constexpr uint32_t MAX_DEPTH = 64;
+
+        float _margin;
+        /// Proxy slots.
+        std::vector<Proxy> _proxies;
+        /// Slots available for reuse.
+        std::vector<uint32_t> _freeSlots;
+        /// Slots removed since the last build, reusable once no leaf refers to them.
+        std::vector<uint32_t> _removedSlots;
+        /// Proxy slot by entity index.
+        std::vector<uint32_t> _slots;
+        /// Slots inserted since the last build, tested linearly by queries.
+        std::vector<uint32_t> _pending;
+        /// Proxy slots referenced by leaves.
+        std::vector<uint32_t> _leafProxies;
+        /// Proxy slot centroids, used while building.
+        std::vector<vec3> _centroids;
+        std::vector<Node> _nodes;
+        /// Nodes allocated by the running build.
+        std::atomic<uint32_t> _nodeCount{ 0 };
+        /// Number of live proxies.
+        uint32_t _liveCount = 0;
+        /// Whether some proxy outgrew its fat bounds since the last refit.
+        bool _refitNeeded = false;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(SpatialIndex);
+    };
+}
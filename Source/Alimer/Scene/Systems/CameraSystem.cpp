@@ -21,17 +21,27 @@
 //
 
 #include "../Systems/CameraSystem.h"
+#include "../Systems/TransformSystem.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/CameraComponent.h"
 
 namespace Alimer
 {
+    CameraSystem::CameraSystem()
+    {
+        Reads<TransformComponent>();
+        Writes<CameraComponent>();
+        RunAfter<TransformSystem>();
+    }
+
     void CameraSystem::Update(EntityManager &entities, double deltaTime)
     {
         ALIMER_UNUSED(deltaTime);
 
+        // Both are value components, cameras are visited chunk by chunk.
         entities.Each<TransformComponent, CameraComponent>(
-            [](Entity e, TransformComponent& transform, CameraComponent& camera) {
+            [](Entity entity, TransformComponent& transform, CameraComponent& camera) {
+            ALIMER_UNUSED(entity);
             camera.Update(transform.GetTransform());
         });
     }
@@ -31,7 +31,8 @@ namespace Alimer
     class ALIMER_API CameraSystem final : public GameSystem
 	{
     public:
-        CameraSystem() = default;
+        /// Constructor.
+        CameraSystem();
 
         void Update(EntityManager &entities, double deltaTime) override;
 	};
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Systems/SpatialSystem.h"
+#include "../Systems/TransformSystem.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/BoundsComponent.h"
+
+namespace Alimer
+{
+    SpatialSystem::SpatialSystem()
+    {
+        Reads<TransformComponent, BoundsComponent>();
+        RunAfter<TransformSystem>();
+    }
+
+    void SpatialSystem::Update(EntityManager &entities, double deltaTime)
+    {
+        ALIMER_UNUSED(deltaTime);
+
+        // Drop destroyed entities and entities that lost a required component. Only structural changes can cause that.
+        const uint32_t structureVersion = std::max(entities.GetStructureVersion<TransformComponent>(),
+            entities.GetStructureVersion<BoundsComponent>());
+        if (structureVersion != _structureVersion)
+        {
+            _structureVersion = structureVersion;
+            _index.ForEach([this, &entities](Entity::Id id, const BoundingBox& bounds) {
+                ALIMER_UNUSED(bounds);
+
+                if (!entities.IsValid(id)
+                    || !entities.HasComponent<TransformComponent>(id)
+                    || !entities.HasComponent<BoundsComponent>(id))
+                {
+                    _removed.push_back(id);
+                }
+            });
+
+            for (Entity::Id id : _removed)
+            {
+                _index.Remove(id);
+            }
+            _removed.clear();
+        }
+
+        // Assigning a component stamps it changed too, so new entities are picked up here as well.
+        const uint32_t lastVersion = GetLastVersion();
+        auto update = [this](Entity entity, TransformComponent& transform, BoundsComponent& bounds) {
+            _index.Update(entity.GetId(), bounds.box.Transformed(transform.GetTransform().GetMatrix()));
+        };
+
+        entities.Each<TransformComponent, BoundsComponent>(update, Changed<TransformComponent>(lastVersion));
+
+        // Entities whose transform changed too were updated above.
+        const uint32_t transformFamily = ComponentIDMapping::GetId<TransformComponent>();
+        entities.Each<TransformComponent, BoundsComponent>(
+            [&](Entity entity, TransformComponent& transform, BoundsComponent& bounds) {
+            if (entities.GetChangedVersion(entity.GetId(), transformFamily) <= lastVersion)
+            {
+                update(entity, transform, bounds);
+            }
+        }, Changed<BoundsComponent>(lastVersion));
+
+        _index.Commit();
+    }
+}
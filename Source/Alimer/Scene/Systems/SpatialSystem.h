@@ -0,0 +1,52 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../../Application/GameSystem.h"
+#include "../SpatialIndex.h"
+
+namespace Alimer
+{
+    /// System that keeps a SpatialIndex of the world bounds of every entity with transform and bounds components.
+    /// Only chunks whose transform or bounds changed since the previous update are visited, and the index is checked
+    /// for stale entities only when the structure of either family moved.
+    class ALIMER_API SpatialSystem final : public GameSystem
+    {
+    public:
+        /// Constructor.
+        SpatialSystem();
+
+        void Update(EntityManager &entities, double deltaTime) override;
+
+        /// Return the spatial index, valid for queries after the system has run.
+        SpatialIndex& GetIndex() { return _index; }
+        const SpatialIndex& GetIndex() const { return _index; }
+
+    private:
+        SpatialIndex _index;
+        /// Highest transform or bounds structure version seen by the previous update.
+        uint32_t _structureVersion = 0;
+        /// Entities to remove, kept to avoid reallocation.
+        std::vector<Entity::Id> _removed;
+    };
+}
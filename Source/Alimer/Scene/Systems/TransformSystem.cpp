@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Systems/TransformSystem.h"
+#include "../Components/TransformComponent.h"
+
+namespace Alimer
+{
+    static constexpr uint32_t NO_PARENT = 0xffffffff;
+
+    /// Nodes per job when a depth level is split across the JobSystem.
+    static constexpr uint32_t TRANSFORM_GRAIN_SIZE = 256;
+
+    TransformSystem::TransformSystem()
+    {
+        Writes<TransformComponent>();
+    }
+
+    void TransformSystem::Rebuild(EntityManager &entities)
+    {
+        _entities.clear();
+        _components.clear();
+        _parents.clear();
+        _levelOffsets.clear();
+
+        // Roots first.
+        entities.Each<TransformComponent>([this](Entity entity, TransformComponent& transform) {
+            if (!transform._parent.IsValid() || !transform._parent.HasComponent<TransformComponent>())
+            {
+                _entities.push_back(entity);
+                _components.push_back(&transform);
+                _parents.push_back(NO_PARENT);
+            }
+        });
+
+        // Breadth first, one depth level at a time.
+        uint32_t begin = 0;
+        while (begin < _components.size())
+        {
+            const uint32_t end = static_cast<uint32_t>(_components.size());
+            _levelOffsets.push_back(begin);
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                for (const Entity& child : _components[i]->_children)
+                {
+                    TransformComponent* childTransform = child.IsValid() ? child.GetComponent<TransformComponent>() : nullptr;
+                    if (childTransform)
+                    {
+                        _entities.push_back(child);
+                        _components.push_back(childTransform);
+                        _parents.push_back(i);
+                    }
+                }
+            }
+
+            begin = end;
+        }
+        _levelOffsets.push_back(static_cast<uint32_t>(_components.size()));
+
+        const size_t count = _components.size();
+        _localMatrices.resize(count);
+        _worldMatrices.resize(count);
+        _dirty.assign(count, 1);
+        for (size_t i = 0; i < count; ++i)
+        {
+            _localMatrices[i] = _components[i]->_localTransform.GetMatrix();
+            _components[i]->_dirty = false;
+        }
+
+        _hierarchyVersion = entities.GetStructureVersion<TransformComponent>();
+    }
+
+    void TransformSystem::UpdateRange(uint32_t begin, uint32_t end)
+    {
+        const uint32_t* parents = _parents.data();
+        const uint8_t* dirty = _dirty.data();
+        const mat4* local = _localMatrices.data();
+        mat4* world = _worldMatrices.data();
+
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            if (!dirty[i])
+                continue;
+
+            const uint32_t parent = parents[i];
+            world[i] = parent == NO_PARENT ? local[i] : world[parent] * local[i];
+
+            _components[i]->_worldTransform = Transform(world[i]);
+            _entities[i].MarkChanged<TransformComponent>();
+        }
+    }
+
+    void TransformSystem::Update(EntityManager &entities, double deltaTime)
+    {
+        ALIMER_UNUSED(deltaTime);
+
+        if (_hierarchyVersion != entities.GetStructureVersion<TransformComponent>())
+        {
+            Rebuild(entities);
+        }
+
+        const uint32_t count = static_cast<uint32_t>(_components.size());
+        if (!count)
+            return;
+
+        // Gather local changes.
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            TransformComponent* transform = _components[i];
+            if (transform->_dirty)
+            {
+                _localMatrices[i] = transform->_localTransform.GetMatrix();
+                _dirty[i] = 1;
+                transform->_dirty = false;
+            }
+        }
+
+        // Propagate dirtiness in a single pass, parents always precede their children.
+        for (uint32_t i = _levelOffsets[1]; i < count; ++i)
+        {
+            _dirty[i] |= _dirty[_parents[i]];
+        }
+
+        // Forward sweep, nodes within a depth level are independent.
+        JobSystem* jobs = Object::GetSubsystem<JobSystem>();
+        const size_t levelCount = _levelOffsets.size() - 1;
+        for (size_t level = 0; level < levelCount; ++level)
+        {
+            const uint32_t levelBegin = _levelOffsets[level];
+            const uint32_t levelSize = _levelOffsets[level + 1] - levelBegin;
+            if (jobs && levelSize > TRANSFORM_GRAIN_SIZE)
+            {
+                jobs->ParallelFor(levelSize, TRANSFORM_GRAIN_SIZE, [this, levelBegin](uint32_t begin, uint32_t end) {
+                    UpdateRange(levelBegin + begin, levelBegin + end);
+                });
+            }
+            else
+            {
+                UpdateRange(levelBegin, levelBegin + levelSize);
+            }
+        }
+
+        std::fill(_dirty.begin(), _dirty.end(), uint8_t(0));
+    }
+}
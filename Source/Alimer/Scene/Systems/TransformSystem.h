@@ -0,0 +1,65 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../../Application/GameSystem.h"
+#include "../../Math/Math.h"
+
+namespace Alimer
+{
+    class TransformComponent;
+
+    /// System that updates world transforms of the whole transform hierarchy.
+    /// Nodes are kept in flat arrays sorted by depth, so that every parent precedes its children.
+    class ALIMER_API TransformSystem final : public GameSystem
+    {
+    public:
+        /// Constructor.
+        TransformSystem();
+
+        void Update(EntityManager &entities, double deltaTime) override;
+
+    private:
+        /// Rebuild depth sorted node arrays from the transform components.
+        void Rebuild(EntityManager &entities);
+        /// Compose world matrices of dirty nodes in [begin, end).
+        void UpdateRange(uint32_t begin, uint32_t end);
+
+        /// Transform structure version of the entity manager the arrays were built from.
+        uint32_t _hierarchyVersion = ~0u;
+        /// Entity of each node.
+        std::vector<Entity> _entities;
+        /// Transform component of each node, a chunk address valid until the transform structure version moves.
+        std::vector<TransformComponent*> _components;
+        /// Parent node index, NO_PARENT for roots.
+        std::vector<uint32_t> _parents;
+        /// Local matrix of each node.
+        std::vector<mat4> _localMatrices;
+        /// World matrix of each node.
+        std::vector<mat4> _worldMatrices;
+        /// Per node dirty flag.
+        std::vector<uint8_t> _dirty;
+        /// First node of each depth level, followed by the node count.
+        std::vector<uint32_t> _levelOffsets;
+    };
+}